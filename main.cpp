@@ -1,21 +1,143 @@
 #include <iostream>
 #include <limits>
 #include <fstream>
+#include <string>
+#include <thread>
+#include <algorithm>
+#include <vector>
+#include <memory>
 #include "src/Solver.hxx"
+#include "src/BatchScheduler.hxx"
+#include "src/BinaryCnf.hxx"
+#include "src/SolverServer.hxx"
+#include "src/OptionParsing.hxx"
 
 using namespace std;
 
+static void printUsage(const char *program)
+{
+    cerr << "Usage: " << program << " [options] < instances\n"
+         << "       " << program << " [options] snapshot...\n"
+         << "  --convert-binary=PATH       write instances read from STDIN as binary snapshots instead of solving\n"
+         << "                              (PATH for single instance, PATH.0, PATH.1, ... otherwise)\n"
+         << "  --verify-snapshot           verify checksum of snapshots (reads whole file before solving)\n"
+         << "  --server=SOCKET             serve solve requests on Unix domain socket (see SolverServer.hxx)\n"
+         << "  --workers=N                 with --server or --slice: number of requests or instances solved\n"
+         << "                              concurrently (default: all cores)\n"
+         << "  --slice=CONFLICTS           interleave instances, CDCL runs in slices of CONFLICTS conflicts (easy\n"
+         << "                              instances first), results printed as they finish after line\n"
+         << "                              \"c instance I\" (default: 0, instances solved one after another)\n";
+    SolverOptions::printUsage(cerr);
+}
+
+/**
+ * Options of @c i-th of @c n instances, each instance gets own proof and checkpoint file
+ */
+static SolverOptions instanceOptions(const SolverOptions &options, size_t i, size_t n)
+{
+    SolverOptions result = options;
+    if (n > 1 && !result.proofPath.empty()) {
+        result.proofPath += '.' + to_string(i);
+    }
+    if (n > 1 && !result.checkpointPath.empty()) {
+        result.checkpointPath += '.' + to_string(i);
+    }
+    return result;
+}
+
+/**
+ * Parsed command line
+ */
+struct CommandLine
+{
+    SolverOptions options;
+    string convertPath;             // convert DIMACS from STDIN into snapshots
+    string serverSocket;            // run as daemon on this socket
+    unsigned workers;
+    unsigned long long slice = 0;   // conflicts of time slice, 0 disables scheduling
+    std::vector<string> snapshots;  // solve these snapshots instead of STDIN
+    bool verifySnapshots = false;   // checksum snapshots at load
+};
+
+static CommandLine parseCommandLine(int argc, char **argv)
+{
+    CommandLine commandLine;
+    SolverOptions &options = commandLine.options;
+    options.threads = max(1u, thread::hardware_concurrency());
+    commandLine.workers = options.threads;
+    for (int i = 1; i < argc; ++i) {
+        string argument = argv[i];
+        if (options.parse(argument) ||
+            parseOption(argument, "convert-binary", commandLine.convertPath) ||
+            parseFlag(argument, "verify-snapshot", commandLine.verifySnapshots) ||
+            parseOption(argument, "server", commandLine.serverSocket) ||
+            parseOption(argument, "workers", commandLine.workers) ||
+            parseOption(argument, "slice", commandLine.slice)) {
+            continue;
+        } else if (argument.compare(0, 2, "--") != 0) {
+            commandLine.snapshots.push_back(argument);
+        } else {
+            throw invalid_argument("Unknown option: >" + argument + "<");
+        }
+    }
+    options.validate();
+    return commandLine;
+}
+
 int main(int argc, char **argv)
 {
+    CommandLine commandLine;
+    try {
+        commandLine = parseCommandLine(argc, argv);
+    } catch (const exception &e) {
+        cerr << e.what() << '\n';
+        printUsage(argv[0]);
+        return 1;
+    }
     // It is possible to work on files instead of STDIN/STDOUT
 //    cout << "c Freak SATSolver" << '\n';
 //    cout << "c Reading from STDIN" << '\n';
+    if (!commandLine.serverSocket.empty()) {
+        SolverServer server(commandLine.serverSocket, commandLine.workers, commandLine.options);
+        server.run();
+        return 0;
+    }
+    // scheduled instances are all loaded before solving starts
+    BatchScheduler scheduler(commandLine.workers, commandLine.slice);
+    bool scheduled = commandLine.slice > 0 && commandLine.convertPath.empty();
+    auto &snapshots = commandLine.snapshots;
+    for (size_t i = 0; i < snapshots.size(); ++i) {
+        auto cnf = make_shared<const BinaryCnf>(snapshots[i], commandLine.verifySnapshots);
+        unique_ptr<Solver> solver(new Solver(cnf, instanceOptions(commandLine.options, i, snapshots.size())));
+        if (scheduled) {
+            scheduler.add(move(solver));
+        } else {
+            solver->solve(std::cout);
+        }
+    }
+    if (!commandLine.snapshots.empty()) {
+        if (scheduled) {
+            scheduler.run(std::cout);
+        }
+        return 0;
+    }
     int n = 1;
     std::cin >> n;
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    while (n--) {
-        Solver solver(std::cin);
-        solver.solve(std::cout);
+    for (int i = 0; i < n; ++i) {
+        unique_ptr<Solver> solver(new Solver(std::cin, instanceOptions(commandLine.options, i, n)));
+        if (scheduled) {
+            scheduler.add(move(solver));
+        } else if (!commandLine.convertPath.empty()) {
+            ofstream out(n == 1 ? commandLine.convertPath : commandLine.convertPath + '.' + to_string(i),
+                         ios::binary);
+            solver->writeBinary(out);
+        } else {
+            solver->solve(std::cout);
+        }
+    }
+    if (scheduled) {
+        scheduler.run(std::cout);
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include "AutomorphismSearch.hxx"
+
+using namespace std;
+
+constexpr unsigned AutomorphismSearch::maxLeavesPerProbe;
+
+AutomorphismSearch::AutomorphismSearch(std::vector<std::vector<unsigned>> adjacency,
+                                       const std::vector<unsigned> &colors, unsigned long long workLimit)
+        : adjacency(move(adjacency)), workLimit(workLimit), order(colors.size()), position(colors.size()),
+          cellStart(colors.size()), cellEnd(colors.size()), isSplitter(colors.size()),
+          neighbourCount(colors.size()), touchedInCell(colors.size()), orbit(colors.size())
+{
+    assert(this->adjacency.size() == colors.size());
+    for (auto &neighbours : this->adjacency) {
+        sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(unique(neighbours.begin(), neighbours.end()), neighbours.end());
+    }
+    iota(orbit.begin(), orbit.end(), 0);
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&colors](unsigned a, unsigned b) {
+        return colors[a] < colors[b];
+    });
+    // cells of unit partition are color classes, every one of them splits others
+    for (unsigned i = 0; i < order.size();) {
+        unsigned j = i;
+        for (; j < order.size() && colors[order[j]] == colors[order[i]]; ++j) {
+            cellStart[order[j]] = i;
+            position[order[j]] = j;
+        }
+        cellEnd[i] = j;
+        nbCells += 1;
+        isSplitter[i] = true;
+        splitters.push_back(i);
+        i = j;
+    }
+    if (refine()) {
+        search();
+    }
+}
+
+const vector<vector<unsigned>> &AutomorphismSearch::getGenerators() const
+{
+    return generators;
+}
+
+void AutomorphismSearch::search()
+{
+    for (unsigned start = 0;;) {
+        start = firstNonSingleton(start);
+        pathCell.push_back(start);
+        pathTrail.push_back(trail.size());
+        pathCells.push_back(nbCells);
+        pathTrace.push_back(traceHash);
+        if (start == order.size()) {
+            break;
+        }
+        pathVertex.push_back(order[start]);
+        if (!individualize(order[start])) {
+            return;
+        }
+    }
+    firstLeaf = order;
+
+    // generators found at deeper levels fix individualized vertices above, so their orbits prune siblings
+    for (auto level = pathVertex.size(); level-- > 0;) {
+        undo(pathTrail[level]);
+        auto start = pathCell[level];
+        vector<unsigned> cell(order.begin() + start, order.begin() + cellEnd[start]);
+        vector<unsigned> failed; // orbits which gave no automorphism
+        for (auto w : cell) {
+            if (work > workLimit) {
+                return;
+            }
+            auto root = findOrbit(w);
+            if (root == findOrbit(pathVertex[level]) || find(failed.begin(), failed.end(), root) != failed.end()) {
+                continue;
+            }
+            auto marker = trail.size();
+            unsigned leaves = 0;
+            bool found = individualize(w) && descend(level + 1, leaves);
+            undo(marker);
+            if (!found) {
+                failed.push_back(root);
+            }
+        }
+    }
+}
+
+bool AutomorphismSearch::descend(std::size_t level, unsigned &leaves)
+{
+    if (nbCells != pathCells[level] || traceHash != pathTrace[level]) {
+        return false;
+    }
+    auto start = firstNonSingleton(pathCell[level - 1]);
+    if (start != pathCell[level]) {
+        return false;
+    }
+    if (start == order.size()) {
+        leaves += 1;
+        vector<unsigned> permutation(order.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            permutation[firstLeaf[i]] = order[i];
+        }
+        if (!isAutomorphism(permutation)) {
+            return false;
+        }
+        for (unsigned v = 0; v < permutation.size(); ++v) {
+            orbit[findOrbit(v)] = findOrbit(permutation[v]);
+        }
+        generators.push_back(move(permutation));
+        return true;
+    }
+    // vertex of first path is tried first, so that generators fix as many vertices as possible
+    vector<unsigned> cell(order.begin() + start, order.begin() + cellEnd[start]);
+    sort(cell.begin(), cell.end());
+    auto same = find(cell.begin(), cell.end(), pathVertex[level]);
+    if (same != cell.end()) {
+        rotate(cell.begin(), same, same + 1);
+    }
+    for (auto u : cell) {
+        auto marker = trail.size();
+        bool found = individualize(u) && descend(level + 1, leaves);
+        undo(marker);
+        if (found) {
+            return true;
+        }
+        if (leaves >= maxLeavesPerProbe || work > workLimit) {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool AutomorphismSearch::refine()
+{
+    for (size_t head = 0; head < splitters.size(); ++head) {
+        auto splitter = splitters[head];
+        isSplitter[splitter] = false;
+        // touched vertices move inside their cells, splitter cell may be one of them
+        splitterVertices.assign(order.begin() + splitter, order.begin() + cellEnd[splitter]);
+        for (auto v : splitterVertices) {
+            for (auto u : adjacency[v]) {
+                if (neighbourCount[u]++ > 0) {
+                    continue;
+                }
+                touched.push_back(u);
+                auto start = cellStart[u];
+                if (cellEnd[start] - start == 1) {
+                    continue;
+                }
+                if (touchedInCell[start]++ == 0) {
+                    touchedCells.push_back(start);
+                }
+                auto target = cellEnd[start] - touchedInCell[start];
+                auto other = order[target];
+                order[position[u]] = other;
+                position[other] = position[u];
+                order[target] = u;
+                position[u] = target;
+            }
+            work += adjacency[v].size();
+        }
+        // cells split in order of their position, so that trace does not depend on vertex numbering
+        sort(touchedCells.begin(), touchedCells.end());
+        for (auto start : touchedCells) {
+            splitCell(start);
+        }
+        for (auto u : touched) {
+            neighbourCount[u] = 0;
+        }
+        touched.clear();
+        touchedCells.clear();
+        if (work > workLimit) {
+            for (auto i = head + 1; i < splitters.size(); ++i) {
+                isSplitter[splitters[i]] = false;
+            }
+            splitters.clear();
+            return false;
+        }
+    }
+    splitters.clear();
+    return true;
+}
+
+void AutomorphismSearch::splitCell(unsigned start)
+{
+    auto end = cellEnd[start];
+    auto tail = end - touchedInCell[start];
+    touchedInCell[start] = 0;
+    auto byCount = [this](unsigned a, unsigned b) { return neighbourCount[a] < neighbourCount[b]; };
+    if (tail == start) {
+        auto range = minmax_element(order.begin() + start, order.begin() + end, byCount);
+        if (neighbourCount[*range.first] == neighbourCount[*range.second]) {
+            return;
+        }
+    }
+    sort(order.begin() + tail, order.begin() + end, byCount);
+    trail.push_back({start, end, traceHash});
+    work += end - tail;
+    bool wasSplitter = isSplitter[start];
+    unsigned largest = start;
+    for (unsigned i = start; i < end;) {
+        // untouched vertices before tail keep their positions and cell
+        auto j = max(i + 1, tail);
+        for (auto k = max(i, tail); k < end && neighbourCount[order[k]] == neighbourCount[order[i]]; ++k) {
+            cellStart[order[k]] = i;
+            position[order[k]] = k;
+            j = k + 1;
+        }
+        cellEnd[i] = j;
+        nbCells += i != start;
+        traceHash = (traceHash ^ (static_cast<size_t>(i) << 32) ^ (static_cast<size_t>(j - i) << 8) ^
+                     neighbourCount[order[i]]) * 0x9E3779B97F4A7C15ull;
+        if (j - i > cellEnd[largest] - largest) {
+            largest = i;
+        }
+        i = j;
+    }
+    // fragments of cell which was already used as splitter imply each other, largest one is left out
+    for (unsigned i = start; i < end; i = cellEnd[i]) {
+        if ((wasSplitter || i != largest) && !isSplitter[i]) {
+            isSplitter[i] = true;
+            splitters.push_back(i);
+        }
+    }
+}
+
+bool AutomorphismSearch::individualize(unsigned vertex)
+{
+    auto start = cellStart[vertex];
+    auto end = cellEnd[start];
+    assert(end - start > 1);
+    trail.push_back({start, end, traceHash});
+    auto last = end - 1;
+    auto other = order[last];
+    order[position[vertex]] = other;
+    position[other] = position[vertex];
+    order[last] = vertex;
+    position[vertex] = last;
+    cellEnd[start] = last;
+    cellEnd[last] = end;
+    cellStart[vertex] = last;
+    nbCells += 1;
+    traceHash = (traceHash ^ start) * 0x9E3779B97F4A7C15ull;
+    work += 1;
+    isSplitter[last] = true;
+    splitters.push_back(last);
+    return refine();
+}
+
+void AutomorphismSearch::undo(std::size_t size)
+{
+    for (; trail.size() > size; trail.pop_back()) {
+        auto &split = trail.back();
+        for (auto i = split.start; i < split.end; i = cellEnd[i]) {
+            nbCells -= 1;
+        }
+        nbCells += 1;
+        cellEnd[split.start] = split.end;
+        for (auto i = split.start; i < split.end; ++i) {
+            cellStart[order[i]] = split.start;
+        }
+        traceHash = split.traceHash;
+    }
+}
+
+unsigned AutomorphismSearch::firstNonSingleton(unsigned from) const
+{
+    for (auto i = from; i < order.size(); i = cellEnd[i]) {
+        if (cellEnd[i] - i > 1) {
+            return i;
+        }
+    }
+    return order.size();
+}
+
+bool AutomorphismSearch::isAutomorphism(const std::vector<unsigned> &permutation)
+{
+    // edges between fixed vertices map to themselves, others are checked from moved endpoint
+    for (unsigned v = 0; v < permutation.size(); ++v) {
+        if (permutation[v] == v) {
+            continue;
+        }
+        auto &image = adjacency[permutation[v]];
+        if (adjacency[v].size() != image.size()) {
+            return false;
+        }
+        work += image.size();
+        for (auto u : adjacency[v]) {
+            if (!binary_search(image.begin(), image.end(), permutation[u])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+unsigned AutomorphismSearch::findOrbit(unsigned vertex)
+{
+    while (orbit[vertex] != vertex) {
+        orbit[vertex] = orbit[orbit[vertex]]; // path halving
+        vertex = orbit[vertex];
+    }
+    return vertex;
+}
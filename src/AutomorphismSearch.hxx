@@ -0,0 +1,117 @@
+#ifndef FREAKSATSOLVER_AUTOMORPHISMSEARCH_HXX
+#define FREAKSATSOLVER_AUTOMORPHISMSEARCH_HXX
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Generators of automorphism group of vertex-colored undirected graph by individualization and refinement. Coloring
+ * is refined to equitable partition (cells split by number of neighbours in splitter cell), then first vertex of
+ * first non-singleton cell is individualized until partition is discrete, which gives first leaf. Bottom-up from
+ * deepest level every other vertex of that cell, which is not in orbit of individualized vertex under generators
+ * found so far, is individualized instead and search descends to leaf with same refinement trace. Permutation between
+ * leaves is kept if it preserves edges. Search may miss generators (descent is bounded), every returned permutation
+ * is verified automorphism.
+ */
+class AutomorphismSearch
+{
+    static constexpr unsigned maxLeavesPerProbe = 8;
+
+    std::vector<std::vector<unsigned>> adjacency; // sorted, no duplicates
+    unsigned long long workLimit;                 // scanned edges and moved vertices
+    unsigned long long work = 0;
+
+    // ordered partition, cells are ranges of order, vertex order inside cell is arbitrary
+    std::vector<unsigned> order;
+    std::vector<unsigned> position;  // vertex -> index in order
+    std::vector<unsigned> cellStart; // vertex -> first index of its cell
+    std::vector<unsigned> cellEnd;   // first index of cell -> index past cell
+    std::size_t nbCells = 0;
+    std::size_t traceHash = 0;       // refinement trace since root, isomorphism invariant
+
+    /**
+     * Split cell, undone by merging range [start, end) back
+     */
+    struct Split
+    {
+        unsigned start;
+        unsigned end;
+        std::size_t traceHash; // before split
+    };
+    std::vector<Split> trail;
+
+    // refinement scratch space
+    std::vector<unsigned> splitters;     // FIFO of cell starts
+    std::vector<bool> isSplitter;        // by cell start
+    std::vector<unsigned> neighbourCount;
+    std::vector<unsigned> touchedInCell; // by cell start, touched vertices are kept at end of cell
+    std::vector<unsigned> touched;
+    std::vector<unsigned> touchedCells;
+    std::vector<unsigned> splitterVertices;
+
+    // first path
+    std::vector<unsigned> firstLeaf;
+    std::vector<unsigned> pathCell;        // level -> first index of individualized cell
+    std::vector<unsigned> pathVertex;      // level -> individualized vertex
+    std::vector<std::size_t> pathTrail;    // level -> trail size before individualization
+    std::vector<std::size_t> pathCells;    // level -> cells before individualization
+    std::vector<std::size_t> pathTrace;    // level -> trace hash before individualization
+
+    std::vector<unsigned> orbit;           // union-find over vertices joined by generators
+    std::vector<std::vector<unsigned>> generators;
+
+public:
+    /**
+     * Vertices are 0 .. adjacency.size() - 1, automorphisms preserve @c colors. Search stops once @c workLimit
+     * edges are scanned.
+     */
+    AutomorphismSearch(std::vector<std::vector<unsigned>> adjacency, const std::vector<unsigned> &colors,
+                       unsigned long long workLimit);
+
+    /**
+     * Each generator maps vertex to its image
+     */
+    const std::vector<std::vector<unsigned>> &getGenerators() const;
+
+private:
+    void search();
+
+    /**
+     * Refines partition by splitters until it is equitable, returns false once work limit is exceeded
+     */
+    bool refine();
+
+    /**
+     * Splits cell by number of neighbours in current splitter, fragments ordered by that number. Untouched vertices
+     * form first fragment and do not move, so split costs touched vertices only.
+     */
+    void splitCell(unsigned start);
+
+    /**
+     * Moves @c vertex into singleton cell at end of its cell and refines
+     */
+    bool individualize(unsigned vertex);
+
+    /**
+     * Merges cells split after trail had @c size entries
+     */
+    void undo(std::size_t size);
+
+    /**
+     * First index of first non-singleton cell at or after @c from, size of order if there is none
+     */
+    unsigned firstNonSingleton(unsigned from) const;
+
+    /**
+     * Descends from partition equivalent to first path at @c level towards leaf which maps first leaf by
+     * automorphism, records it. Returns true on success.
+     */
+    bool descend(std::size_t level, unsigned &leaves);
+
+    bool isAutomorphism(const std::vector<unsigned> &permutation);
+
+    unsigned findOrbit(unsigned vertex);
+};
+
+
+#endif //FREAKSATSOLVER_AUTOMORPHISMSEARCH_HXX
@@ -0,0 +1,59 @@
+#include <cassert>
+#include "BackboneComputation.hxx"
+#include "Solver.hxx"
+
+using namespace std;
+
+BackboneComputation::BackboneComputation(Solver &satInstance) : satInstance(satInstance), cdcl(satInstance),
+                                                                backbone(satInstance.nbVariables + 1,
+                                                                         Variable::UNKNOWN)
+{ }
+
+SolverResult BackboneComputation::trySolve()
+{
+    auto result = cdcl.trySolve();
+    if (result != SolverResult::SAT) {
+        return result;
+    }
+    auto candidates = cdcl.getModel();
+    for (int variable = 1; variable <= satInstance.nbVariables; ++variable) {
+        if (candidates[variable] == Variable::UNKNOWN) {
+            continue; // model of other candidate showed it can take both values
+        }
+        int l = candidates[variable] == Variable::POSITIVE ? variable : -variable;
+        cdcl.setAssumptions({-l});
+        result = cdcl.trySolve();
+        if (result == SolverResult::UNKNOWN) {
+            return result;
+        }
+        if (result == SolverResult::UNSAT) {
+            assert(!cdcl.getFailedAssumptions().empty());
+            backbone[variable] = candidates[variable];
+            cdcl.addClause({l}); // implied, shortens following searches
+            continue;
+        }
+        auto model = cdcl.getModel();
+        for (int other = variable + 1; other <= satInstance.nbVariables; ++other) {
+            if (model[other] != candidates[other]) {
+                candidates[other] = Variable::UNKNOWN;
+            }
+        }
+    }
+    cdcl.setAssumptions({});
+    return SolverResult::SAT;
+}
+
+const vector<Variable> BackboneComputation::getModel() const
+{
+    return backbone;
+}
+
+const Statistics &BackboneComputation::getStatistics() const
+{
+    return cdcl.getStatistics();
+}
+
+const char *BackboneComputation::getExhaustedResource() const
+{
+    return cdcl.getExhaustedResource();
+}
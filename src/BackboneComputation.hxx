@@ -0,0 +1,42 @@
+#ifndef FREAKSATSOLVER_BACKBONECOMPUTATION_HXX
+#define FREAKSATSOLVER_BACKBONECOMPUTATION_HXX
+
+#include <vector>
+#include "SolverResult.hxx"
+#include "Variable.hxx"
+#include "Statistics.hxx"
+#include "GraspTwlImplementation.hxx"
+
+class Solver;
+
+/**
+ * Backbone (literals true in every model) by single incremental CDCL engine. Each candidate literal of first model is
+ * tested by solving under assumption of its negation. UNSAT proves it, it is then added as unit clause. Model found
+ * instead drops every candidate it disagrees with.
+ */
+class BackboneComputation
+{
+    Solver &satInstance;
+    GraspTwlImplementation<> cdcl;
+    std::vector<Variable> backbone; // variable -> value in every model, UNKNOWN if variable is not in backbone
+
+public:
+    BackboneComputation(Solver &satInstance);
+
+    /**
+     * SAT once backbone is complete
+     */
+    SolverResult trySolve();
+
+    /**
+     * Backbone, other variables are UNKNOWN
+     */
+    const std::vector<Variable> getModel() const;
+
+    const Statistics &getStatistics() const;
+
+    const char *getExhaustedResource() const;
+};
+
+
+#endif //FREAKSATSOLVER_BACKBONECOMPUTATION_HXX
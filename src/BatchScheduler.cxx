@@ -0,0 +1,87 @@
+#include <cmath>
+#include <functional>
+#include <ostream>
+#include <sstream>
+#include <thread>
+#include "BatchScheduler.hxx"
+
+using namespace std;
+
+/**
+ * Key decrease per slice dispatched while task waits, in units of task weight (log of formula size)
+ */
+constexpr double agingRate = 1.0;
+
+BatchScheduler::BatchScheduler(unsigned nbWorkers, unsigned long long quantum) : nbWorkers(max(1u, nbWorkers)),
+                                                                                quantum(quantum)
+{ }
+
+void BatchScheduler::add(std::unique_ptr<Solver> solver)
+{
+    size_t literals = 0;
+    for (auto &clause : solver->formula) {
+        literals += clause.size();
+    }
+    tasks.push_back({move(solver), log2(2.0 + literals)});
+}
+
+void BatchScheduler::run(std::ostream &out)
+{
+    {
+        lock_guard<mutex> lock(queueMutex);
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            enqueue(i);
+        }
+    }
+    vector<thread> workers;
+    for (unsigned i = 1; i < min<size_t>(nbWorkers, tasks.size()); ++i) {
+        workers.emplace_back(&BatchScheduler::work, this, ref(out));
+    }
+    work(out);
+    for (auto &t : workers) {
+        t.join();
+    }
+}
+
+void BatchScheduler::work(std::ostream &out)
+{
+    ostringstream result;
+    for (;;) {
+        size_t taskIdx;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            // running task may come back to queue
+            queueChanged.wait(lock, [this]() { return !queue.empty() || running == 0; });
+            if (queue.empty()) {
+                return;
+            }
+            taskIdx = queue.top().second;
+            queue.pop();
+            running += 1;
+            dispatched += 1;
+        }
+        auto &task = tasks[taskIdx];
+        result.str("");
+        bool finished = task.solver->solveSlice(result, quantum);
+        {
+            lock_guard<mutex> lock(queueMutex);
+            running -= 1;
+            if (finished) {
+                out << "c instance " << taskIdx << '\n' << result.str() << flush;
+                task.solver.reset();
+            } else {
+                task.slices += 1;
+                enqueue(taskIdx);
+            }
+        }
+        queueChanged.notify_all();
+    }
+}
+
+void BatchScheduler::enqueue(std::size_t taskIdx)
+{
+    auto &task = tasks[taskIdx];
+    // key of waiting task effectively drops by agingRate per dispatched slice: adding dispatch clock at enqueue time
+    // orders the same as subtracting time waited
+    queue.emplace((task.slices + 1) * task.weight + agingRate * dispatched, taskIdx);
+}
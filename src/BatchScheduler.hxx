@@ -0,0 +1,69 @@
+#ifndef FREAKSATSOLVER_BATCHSCHEDULER_HXX
+#define FREAKSATSOLVER_BATCHSCHEDULER_HXX
+
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <condition_variable>
+#include <utility>
+#include <vector>
+#include "Solver.hxx"
+
+/**
+ * Solves batch of instances concurrently in time slices, so that easy instances are not stuck behind hard ones.
+ * Worker takes instance with lowest key, runs single slice of its search (@c Solver::solveSlice) and queues it again
+ * unless it finished. Key estimates remaining work: slices already run times formula size (runs which took long tend
+ * to take longer), lowered by aging while instance waits so that hard instances still progress.
+ * Results are printed as instances finish, each preceded by line "c instance I" (I counted from 0 in input order).
+ */
+class BatchScheduler
+{
+    struct Task
+    {
+        std::unique_ptr<Solver> solver; // engine of suspended solve refers to it, so it never moves
+        double weight;                  // expected work of single slice
+        unsigned slices = 0;
+    };
+
+    typedef std::pair<double, std::size_t> QueueEntry; // key, task
+
+    unsigned nbWorkers;
+    unsigned long long quantum;
+    std::vector<Task> tasks;
+
+    std::mutex queueMutex;
+    std::condition_variable queueChanged;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+    unsigned running = 0;
+    unsigned long long dispatched = 0; // slices started, clock of aging
+
+public:
+    /**
+     * @c quantum is number of conflicts of single slice
+     */
+    BatchScheduler(unsigned nbWorkers, unsigned long long quantum);
+
+    BatchScheduler(const BatchScheduler &) = delete;
+
+    BatchScheduler &operator=(const BatchScheduler &) = delete;
+
+    void add(std::unique_ptr<Solver> solver);
+
+    /**
+     * Solves all added instances
+     */
+    void run(std::ostream &out);
+
+private:
+    void work(std::ostream &out);
+
+    /**
+     * Queues task, must hold queueMutex
+     */
+    void enqueue(std::size_t taskIdx);
+};
+
+
+#endif //FREAKSATSOLVER_BATCHSCHEDULER_HXX
@@ -0,0 +1,158 @@
+#include <cstring>
+#include <cerrno>
+#include <ostream>
+#include <system_error>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "BinaryCnf.hxx"
+#include "BinaryCnfFormatException.hxx"
+
+using namespace std;
+
+constexpr char BinaryCnf::magic[8];
+constexpr uint32_t BinaryCnf::version;
+constexpr uint64_t BinaryCnf::checksumBasis;
+
+BinaryCnf::BinaryCnf(const std::string &path, bool verifyChecksum)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw system_error(errno, system_category(), "Unable to open >" + path + "<");
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        auto error = errno;
+        close(fd);
+        throw system_error(error, system_category(), "Unable to stat >" + path + "<");
+    }
+    mappingSize = status.st_size;
+    if (mappingSize > 0) {
+        mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    auto error = errno;
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw system_error(error, system_category(), "Unable to map >" + path + "<");
+    }
+    try {
+        validate(mapping, mappingSize, verifyChecksum);
+    } catch (...) {
+        munmap(mapping, mappingSize);
+        throw;
+    }
+}
+
+BinaryCnf::BinaryCnf(const void *data, std::size_t size, bool verifyChecksum)
+{
+    validate(data, size, verifyChecksum);
+}
+
+BinaryCnf::~BinaryCnf()
+{
+    if (mapping) {
+        munmap(mapping, mappingSize);
+    }
+}
+
+int32_t BinaryCnf::getNbVariables() const
+{
+    return header->nbVariables;
+}
+
+uint64_t BinaryCnf::getNbClauses() const
+{
+    return header->nbClauses;
+}
+
+const int32_t *BinaryCnf::clauseBegin(std::uint64_t clauseIdx) const
+{
+    return literals + offsets[clauseIdx];
+}
+
+const int32_t *BinaryCnf::clauseEnd(std::uint64_t clauseIdx) const
+{
+    return literals + offsets[clauseIdx + 1];
+}
+
+void BinaryCnf::write(const Solver &satInstance, std::ostream &out)
+{
+    if (!satInstance.cardinalityConstraints.empty() || !satInstance.xorConstraints.empty()) {
+        throw BinaryCnfFormatException("Snapshot cannot hold XOR and cardinality constraints");
+    }
+    if (satInstance.weighted) {
+        throw BinaryCnfFormatException("Snapshot cannot hold weighted instance");
+    }
+    Header header = {};
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.nbVariables = satInstance.nbVariables;
+    header.nbClauses = satInstance.nbClauses;
+    vector<uint64_t> offsets(1, 0);
+    for (uint64_t i = 0; i < satInstance.nbClauses; ++i) {
+        offsets.push_back(offsets.back() + satInstance.formula[i].size());
+    }
+    header.nbLiterals = offsets.back();
+    header.checksum = checksum(offsets.data(), offsets.size() * sizeof(uint64_t));
+    for (uint64_t i = 0; i < satInstance.nbClauses; ++i) {
+        auto &clause = satInstance.formula[i];
+        header.checksum = checksum(clause.data(), clause.size() * sizeof(int32_t), header.checksum);
+    }
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    for (uint64_t i = 0; i < satInstance.nbClauses; ++i) {
+        auto &clause = satInstance.formula[i];
+        static_assert(sizeof(clause[0]) == sizeof(int32_t), "snapshot stores 32-bit literals");
+        out.write(reinterpret_cast<const char *>(clause.data()), clause.size() * sizeof(int32_t));
+    }
+    if (!out) {
+        throw system_error(make_error_code(errc::io_error), "Unable to write binary CNF");
+    }
+}
+
+void BinaryCnf::validate(const void *data, std::size_t size, bool verifyChecksum)
+{
+    if (size < sizeof(Header)) {
+        throw BinaryCnfFormatException("Truncated header");
+    }
+    header = static_cast<const Header *>(data);
+    if (memcmp(header->magic, magic, sizeof(magic)) != 0) {
+        throw BinaryCnfFormatException("Not a binary CNF snapshot");
+    }
+    if (header->version != version) {
+        throw BinaryCnfFormatException("Unsupported snapshot version: " + to_string(header->version));
+    }
+    auto offsetsSize = (header->nbClauses + 1) * sizeof(uint64_t);
+    auto literalsSize = header->nbLiterals * sizeof(int32_t);
+    if (header->nbVariables < 0 || header->nbClauses >= size || header->nbLiterals >= size ||
+        size != sizeof(Header) + offsetsSize + literalsSize) {
+        throw BinaryCnfFormatException("Snapshot size does not match header");
+    }
+    offsets = reinterpret_cast<const uint64_t *>(header + 1);
+    literals = reinterpret_cast<const int32_t *>(offsets + header->nbClauses + 1);
+    if (verifyChecksum && checksum(offsets, offsetsSize + literalsSize) != header->checksum) {
+        throw BinaryCnfFormatException("Checksum mismatch");
+    }
+    if (offsets[0] != 0 || offsets[header->nbClauses] != header->nbLiterals) {
+        throw BinaryCnfFormatException("Clause offsets out of range");
+    }
+    for (uint64_t i = 0; i < header->nbClauses; ++i) {
+        if (offsets[i] > offsets[i + 1]) {
+            throw BinaryCnfFormatException("Clause offsets are not monotone");
+        }
+    }
+}
+
+uint64_t BinaryCnf::checksum(const void *data, std::size_t size, std::uint64_t hash)
+{
+    // FNV-1a over 32-bit words, data is always multiple of 4 bytes
+    constexpr uint64_t prime = 1099511628211ull;
+    auto words = static_cast<const uint32_t *>(data);
+    for (size_t i = 0; i < size / sizeof(uint32_t); ++i) {
+        hash = (hash ^ words[i]) * prime;
+    }
+    return hash;
+}
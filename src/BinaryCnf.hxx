@@ -0,0 +1,77 @@
+#ifndef FREAKSATSOLVER_BINARYCNF_HXX
+#define FREAKSATSOLVER_BINARYCNF_HXX
+
+#include <cstdint>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include "Solver.hxx"
+
+/**
+ * Precompiled CNF snapshot. Layout (native byte order):
+ * header, uint64 clause offsets [nbClauses + 1] into literals, int32 literals [nbLiterals].
+ * Checksum covers offsets and literals. Verifying it reads whole file, so it is done only on request and loading
+ * touches just the offsets, literals are paged in when engine copies them.
+ */
+class BinaryCnf
+{
+public:
+    struct Header
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::int32_t nbVariables;
+        std::uint64_t nbClauses;
+        std::uint64_t nbLiterals;
+        std::uint64_t checksum;
+    };
+
+    static constexpr char magic[8] = {'F', 'S', 'A', 'T', 'C', 'N', 'F', '\0'};
+    static constexpr std::uint32_t version = 1;
+    static constexpr std::uint64_t checksumBasis = 14695981039346656037ull; // FNV-1a offset basis
+
+private:
+    void *mapping = nullptr;
+    std::size_t mappingSize = 0;
+    const Header *header = nullptr;
+    const std::uint64_t *offsets = nullptr;
+    const std::int32_t *literals = nullptr;
+
+public:
+    /**
+     * Maps snapshot from file at @c path read-only and validates its layout, checksum too if @c verifyChecksum
+     */
+    explicit BinaryCnf(const std::string &path, bool verifyChecksum = false);
+
+    /**
+     * Validates snapshot stored in memory. @c data has to outlive this object.
+     */
+    BinaryCnf(const void *data, std::size_t size, bool verifyChecksum = false);
+
+    BinaryCnf(const BinaryCnf &) = delete;
+
+    BinaryCnf &operator=(const BinaryCnf &) = delete;
+
+    ~BinaryCnf();
+
+    std::int32_t getNbVariables() const;
+
+    std::uint64_t getNbClauses() const;
+
+    const std::int32_t *clauseBegin(std::uint64_t clauseIdx) const;
+
+    const std::int32_t *clauseEnd(std::uint64_t clauseIdx) const;
+
+    /**
+     * Writes original clauses of @c satInstance as snapshot
+     */
+    static void write(const Solver &satInstance, std::ostream &out);
+
+private:
+    void validate(const void *data, std::size_t size, bool verifyChecksum);
+
+    static std::uint64_t checksum(const void *data, std::size_t size, std::uint64_t hash = checksumBasis);
+};
+
+
+#endif //FREAKSATSOLVER_BINARYCNF_HXX
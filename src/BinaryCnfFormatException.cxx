@@ -0,0 +1 @@
+#include "BinaryCnfFormatException.hxx"
@@ -0,0 +1,15 @@
+#ifndef FREAKSATSOLVER_BINARYCNFFORMATEXCEPTION_HXX
+#define FREAKSATSOLVER_BINARYCNFFORMATEXCEPTION_HXX
+
+#include <stdexcept>
+
+/**
+ * Signals corrupted or incompatible binary CNF snapshot
+ */
+class BinaryCnfFormatException : public std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+
+#endif //FREAKSATSOLVER_BINARYCNFFORMATEXCEPTION_HXX
@@ -0,0 +1,80 @@
+#include <fstream>
+#include <unistd.h>
+#include "Budget.hxx"
+
+using namespace std;
+
+CancellationToken::CancellationToken() : cancelled{make_shared<atomic<bool>>(false)}
+{ }
+
+CancellationToken CancellationToken::child() const
+{
+    CancellationToken result = *this;
+    result.cancelled.push_back(make_shared<atomic<bool>>(false));
+    return result;
+}
+
+void CancellationToken::cancel()
+{
+    cancelled.back()->store(true, memory_order_relaxed);
+}
+
+bool CancellationToken::isCancelled() const
+{
+    for (auto &flag : cancelled) {
+        if (flag->load(memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Budget::Budget(const ResourceLimits &limits, const CancellationToken &cancellation) : limits(limits),
+                                                                                    cancellation(cancellation),
+                                                                                    start(chrono::steady_clock::now()),
+                                                                                    startResidentMemory(0)
+{
+    if (limits.memoryLimit) {
+        startResidentMemory = residentMemory(); // memory of formula and earlier solves is not charged
+    }
+}
+
+bool Budget::isExhausted(const Statistics &statistics)
+{
+    constexpr unsigned samplingPeriod = 256;
+    if (exhaustedResource) {
+        return true;
+    }
+    if (limits.conflictLimit && statistics.conflicts >= limits.conflictLimit) {
+        exhaustedResource = "conflicts";
+    } else if (limits.propagationLimit && statistics.propagations >= limits.propagationLimit) {
+        exhaustedResource = "propagations";
+    } else if (callsUntilSample-- == 0) {
+        callsUntilSample = samplingPeriod;
+        if (cancellation.isCancelled()) {
+            exhaustedResource = "cancelled";
+        } else if (limits.timeLimit > 0 &&
+                   chrono::duration<double>(chrono::steady_clock::now() - start).count() >= limits.timeLimit) {
+            exhaustedResource = "time";
+        } else if (limits.memoryLimit && residentMemory() >= startResidentMemory + limits.memoryLimit) {
+            // peak of process (getrusage) would charge every later solve of batch or server with earlier ones
+            exhaustedResource = "memory";
+        }
+    }
+    return exhaustedResource != nullptr;
+}
+
+const char *Budget::getExhaustedResource() const
+{
+    return exhaustedResource;
+}
+
+size_t Budget::residentMemory()
+{
+    ifstream statm("/proc/self/statm");
+    size_t totalPages, residentPages;
+    if (!(statm >> totalPages >> residentPages)) {
+        return 0;
+    }
+    return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
@@ -0,0 +1,75 @@
+#ifndef FREAKSATSOLVER_BUDGET_HXX
+#define FREAKSATSOLVER_BUDGET_HXX
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "Statistics.hxx"
+
+/**
+ * Hard limits of single solver run. Zero means "no limit".
+ */
+struct ResourceLimits
+{
+    double timeLimit = 0;                     // wall-clock seconds
+    unsigned long long conflictLimit = 0;
+    unsigned long long propagationLimit = 0;
+    std::size_t memoryLimit = 0;              // resident memory grown since start of solve in bytes
+};
+
+/**
+ * Shared flag which allows external party (scheduler) to interrupt running solve. Copies share state.
+ */
+class CancellationToken
+{
+    std::vector<std::shared_ptr<std::atomic<bool>>> cancelled; // own flag at the back, ancestors before it
+
+public:
+    CancellationToken();
+
+    /**
+     * Returns token cancelled together with this one, which can be also cancelled alone
+     */
+    CancellationToken child() const;
+
+    void cancel();
+
+    bool isCancelled() const;
+};
+
+/**
+ * Tracks resources consumed by single solve against @c ResourceLimits.
+ */
+class Budget
+{
+    ResourceLimits limits;
+    CancellationToken cancellation;
+    std::chrono::steady_clock::time_point start;
+    std::size_t startResidentMemory;
+    unsigned callsUntilSample = 0;
+    const char *exhaustedResource = nullptr;
+
+public:
+    Budget(const ResourceLimits &limits, const CancellationToken &cancellation);
+
+    /**
+     * Returns true if any limit is exceeded. Counters are compared on every call, clock, memory and cancellation
+     * token are sampled only once per many calls, so this is cheap enough for inner search loop.
+     */
+    bool isExhausted(const Statistics &statistics);
+
+    /**
+     * Name of resource which ran out or nullptr
+     */
+    const char *getExhaustedResource() const;
+
+    /**
+     * Current resident memory of this process in bytes
+     */
+    static std::size_t residentMemory();
+};
+
+
+#endif //FREAKSATSOLVER_BUDGET_HXX
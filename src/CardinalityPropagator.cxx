@@ -0,0 +1,76 @@
+#include <cassert>
+#include "CardinalityPropagator.hxx"
+
+using namespace std;
+
+constexpr unsigned CardinalityPropagator::noConflict;
+
+CardinalityPropagator::CardinalityPropagator(const std::vector<CardinalityConstraint> &constraints, int nbVariables,
+                                             const Variable *value) : constraints(constraints),
+                                                                      occurrences(2 * nbVariables + 1),
+                                                                      occurrencesOf(occurrences.data() + nbVariables),
+                                                                      trueCount(constraints.size()),
+                                                                      value(value)
+{
+    for (unsigned constraintIdx = 0; constraintIdx < constraints.size(); ++constraintIdx) {
+        for (auto l : constraints[constraintIdx].literals) {
+            occurrencesOf[l].push_back(constraintIdx);
+        }
+        if (constraints[constraintIdx].bound == 0) {
+            unitConstraints.push_back(constraintIdx);
+        }
+    }
+}
+
+unsigned CardinalityPropagator::propagate(int l, std::vector<ConstraintImplication> &implied) const
+{
+    for (auto constraintIdx : occurrencesOf[l]) {
+        auto &constraint = constraints[constraintIdx];
+        if (trueCount[constraintIdx] > constraint.bound) {
+            return constraintIdx;
+        }
+        if (trueCount[constraintIdx] == constraint.bound) {
+            for (auto ll : constraint.literals) {
+                if (value[ll] == Variable::UNKNOWN) {
+                    implied.push_back({-ll, constraintIdx, false});
+                }
+            }
+        }
+    }
+    return noConflict;
+}
+
+unsigned CardinalityPropagator::propagateUnits(std::vector<ConstraintImplication> &implied) const
+{
+    for (auto constraintIdx : unitConstraints) {
+        for (auto l : constraints[constraintIdx].literals) {
+            if (value[l] == Variable::POSITIVE) {
+                return constraintIdx;
+            }
+            if (value[l] == Variable::UNKNOWN) {
+                implied.push_back({-l, constraintIdx, true});
+            }
+        }
+    }
+    return noConflict;
+}
+
+void CardinalityPropagator::conflictVariables(unsigned constraintIdx, std::vector<int> &variables) const
+{
+    assert(trueCount[constraintIdx] > constraints[constraintIdx].bound);
+    reasonVariables(constraintIdx, [](int) { return true; }, variables);
+}
+
+bool CardinalityPropagator::isSatisfied() const
+{
+    for (auto &constraint : constraints) {
+        unsigned count = 0;
+        for (auto l : constraint.literals) {
+            count += value[l] == Variable::POSITIVE;
+        }
+        if (count > constraint.bound) {
+            return false;
+        }
+    }
+    return true;
+}
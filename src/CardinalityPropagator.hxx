@@ -0,0 +1,98 @@
+#ifndef FREAKSATSOLVER_CARDINALITYPROPAGATOR_HXX
+#define FREAKSATSOLVER_CARDINALITYPROPAGATOR_HXX
+
+#include <cstdlib>
+#include <vector>
+#include "Variable.hxx"
+#include "ExtendedConstraints.hxx"
+
+/**
+ * Counter based propagation of at-most-k constraints. Every constraint counts its true literals, engine reports each
+ * assignment and unassignment. When count reaches bound, remaining literals are implied false. Reason of implication
+ * is constraint index, reason clause consists of true literals assigned before implied one.
+ */
+class CardinalityPropagator
+{
+    std::vector<CardinalityConstraint> constraints;
+    std::vector<std::vector<unsigned>> occurrences; // literal -> constraints containing it
+    std::vector<unsigned> *occurrencesOf;           // occurrences shifted such that occurrencesOf[l] belongs to l
+    std::vector<unsigned> trueCount;                // constraint -> number of true literals
+    std::vector<unsigned> unitConstraints;          // constraints with bound 0
+    const Variable *value;                          // engine values, value[l] is value of literal l
+
+public:
+    static constexpr unsigned noConflict = ~0u;
+
+    CardinalityPropagator(const std::vector<CardinalityConstraint> &constraints, int nbVariables,
+                          const Variable *value);
+
+    CardinalityPropagator(const CardinalityPropagator &) = delete;
+
+    CardinalityPropagator &operator=(const CardinalityPropagator &) = delete;
+
+    bool empty() const
+    {
+        return constraints.empty();
+    }
+
+    /**
+     * @c l has been made true
+     */
+    void assigned(int l)
+    {
+        for (auto constraintIdx : occurrencesOf[l]) {
+            trueCount[constraintIdx] += 1;
+        }
+    }
+
+    /**
+     * @c l was true and has been unassigned
+     */
+    void unassigned(int l)
+    {
+        for (auto constraintIdx : occurrencesOf[l]) {
+            trueCount[constraintIdx] -= 1;
+        }
+    }
+
+    /**
+     * @c l has been made true. Appends literals implied false to @c implied, returns violated constraint or
+     * noConflict.
+     */
+    unsigned propagate(int l, std::vector<ConstraintImplication> &implied) const;
+
+    /**
+     * Implies literals of constraints with bound 0, they are never triggered by assignment
+     */
+    unsigned propagateUnits(std::vector<ConstraintImplication> &implied) const;
+
+    /**
+     * Appends variables of true literals of violated constraint
+     */
+    void conflictVariables(unsigned constraintIdx, std::vector<int> &variables) const;
+
+    /**
+     * Appends variables of true literals of constraint @c constraintIdx for which @c assignedBefore holds. Those are
+     * antecedents of literal implied by constraint.
+     */
+    template<typename AssignedBefore>
+    void reasonVariables(unsigned constraintIdx, AssignedBefore assignedBefore, std::vector<int> &variables) const;
+
+    /**
+     * Checks all constraints under current assignment
+     */
+    bool isSatisfied() const;
+};
+
+template<typename AssignedBefore>
+void CardinalityPropagator::reasonVariables(unsigned constraintIdx, AssignedBefore assignedBefore,
+                                            std::vector<int> &variables) const
+{
+    for (auto l : constraints[constraintIdx].literals) {
+        if (value[l] == Variable::POSITIVE && assignedBefore(l)) {
+            variables.push_back(std::abs(l));
+        }
+    }
+}
+
+#endif //FREAKSATSOLVER_CARDINALITYPROPAGATOR_HXX
@@ -1,102 +1,62 @@
-#include <cassert>
 #include "ChaffTwoWatchedLiterals.hxx"
 #include "GraspTwlImplementation.hxx"
 
 using namespace std;
 
-ChaffTwoWatchedLiterals::ChaffTwoWatchedLiterals(Solver &satInstance, GraspTwlImplementation &dpllUpImplementation)
-        : satInstance(satInstance), dpllUpImplementation(dpllUpImplementation), clausesInfo(satInstance.formula.size())
+template<typename Engine>
+constexpr unsigned ChaffTwoWatchedLiterals<Engine>::noConflict;
+
+template<typename Engine>
+ChaffTwoWatchedLiterals<Engine>::ChaffTwoWatchedLiterals(Engine &dpllUpImplementation)
+        : watches(dpllUpImplementation.values.size()), // literal range of engine
+          watchesOf(watches.data() + dpllUpImplementation.conflictVertexIdx),
+          dpllUpImplementation(dpllUpImplementation)
 {
-    for (unsigned clauseIdx = 0; clauseIdx < satInstance.formula.size(); ++clauseIdx) {
-        auto &clause = satInstance.formula[clauseIdx];
-        ClauseInfo clauseInfo;
-        int literalsCollected = 0;
-        bool skipClause = false;
-        for (unsigned i = 0; i < clause.size(); ++i) {
-            auto value = dpllUpImplementation.literalValue(clause[i]);
-            if (value == Variable::UNKNOWN) {
-                clauseInfo.literalIdx[literalsCollected++] = i;
-                if (literalsCollected == 2) {
-                    break;
-                }
-            } else if (value == Variable::NEGATIVE) {
-                // skip literal
-            } else {
-                assert(value == Variable::POSITIVE);
-                // skip clause
-                skipClause = true;
-                break;
-            }
-        }
-        if (skipClause) {
-            continue;
-        }
-        if (literalsCollected == 1) {
-            // unit clause - skip
-            continue;
-        }
-        if (literalsCollected == 0) {
-            continue; // clause is negative
-        }
-        clauseInfo.unknownPoolBegin = clauseInfo.literalIdx[1] + 1;
-        clausesInfo[clauseIdx] = clauseInfo;
-        twl.insert({clause[clauseInfo.literalIdx[0]], {clauseIdx, clauseInfo.literalIdx[0]}});
-        twl.insert({clause[clauseInfo.literalIdx[1]], {clauseIdx, clauseInfo.literalIdx[1]}});
-    }
+    reset();
 }
 
-ChaffTwoWatchedLiterals::ClausesRange ChaffTwoWatchedLiterals::watchedOccurrences(Literal l)
+template<typename Engine>
+void ChaffTwoWatchedLiterals<Engine>::watchClause(unsigned clauseIdx)
 {
-    return twl.equal_range(l);
+    auto &clause = dpllUpImplementation.formula[clauseIdx];
+    watchesOf[clause[0]].push_back(clauseIdx);
+    watchesOf[clause[1]].push_back(clauseIdx);
 }
 
-ChaffTwoWatchedLiterals::Literal ChaffTwoWatchedLiterals::literalIsGoingToNegative(LiteralInClauseHandle clause)
+template<typename Engine>
+void ChaffTwoWatchedLiterals<Engine>::reset()
 {
-    LiteralInClause &infoPack = clause->second;
-    ClauseInfo &clauseInfo = clausesInfo[infoPack.clauseIdx];
-    int thisLiteralOffset = (clauseInfo.literalIdx[1] == infoPack.literalIdx); // offset of l
-    int otherLiteralOffset = (thisLiteralOffset == 0 ? 1 : 0);
-    assert(clauseInfo.unknownPoolBegin > max(clauseInfo.literalIdx[0], clauseInfo.literalIdx[1]));
-    auto clauseIdx = infoPack.clauseIdx;
-    auto clauseSize = satInstance.formula[clauseIdx].size();
-    if (clauseInfo.unknownPoolBegin == clauseSize + 1) {
-        // everything was checked, clause is burned. If we are here - clause is positive and we need to do nothing here and in UP
-        Literal literal0 = satInstance.formula[clauseIdx][clauseInfo.literalIdx[0]];
-        Literal literal1 = satInstance.formula[clauseIdx][clauseInfo.literalIdx[1]];
-        assert(dpllUpImplementation.literalValue(literal0) == Variable::POSITIVE ||
-               dpllUpImplementation.literalValue(literal1) == Variable::POSITIVE);
-        return 0;
+    for (auto &list : watches) {
+        list.clear();
     }
-    auto newLiteralToWatchIndex = clauseSize;
-    for (auto candidateLiteralIdx = clauseInfo.unknownPoolBegin;
-         candidateLiteralIdx < clauseSize; ++candidateLiteralIdx) {
-        if (dpllUpImplementation.literalValue(satInstance.formula[clauseIdx][candidateLiteralIdx]) ==
-            Variable::NEGATIVE) {
-            continue;
-        } else if (dpllUpImplementation.literalValue(satInstance.formula[clauseIdx][candidateLiteralIdx]) ==
-                   Variable::POSITIVE) {
-            clauseInfo.unknownPoolBegin = candidateLiteralIdx; // store hint
-            return 0; // whole clause is already positive - do nothing (also in UP)
-        } else {
-            newLiteralToWatchIndex = candidateLiteralIdx;
-            break;
+    auto &formula = dpllUpImplementation.formula;
+    for (unsigned clauseIdx = 0; clauseIdx < formula.size(); ++clauseIdx) {
+        if (formula[clauseIdx].size() >= 2) {
+            watchClause(clauseIdx);
         }
     }
-    clauseInfo.unknownPoolBegin = newLiteralToWatchIndex + 1;
-    if (newLiteralToWatchIndex == clauseSize) {
-        // there is no non-false literal J in clause\{h,l}
-        return satInstance.formula[clauseIdx][clauseInfo.literalIdx[otherLiteralOffset]]; // = h
-        // any further invocation is now locked - h is positive and so is the clause, or we already failed
-    }
+}
 
-    // update TWL structure
-    clauseInfo.literalIdx[thisLiteralOffset] = newLiteralToWatchIndex;
-    // infoPack is now dangling pointer ...
-    twl.erase(clause);
-    twl.insert({satInstance.formula[clauseIdx][newLiteralToWatchIndex], {clauseIdx, newLiteralToWatchIndex}});
+template
+class ChaffTwoWatchedLiterals<GraspTwlImplementation<int16_t, NoStatistics, NoProof>>;
 
-    return 0;
-}
+template
+class ChaffTwoWatchedLiterals<GraspTwlImplementation<int16_t, NoStatistics, DratProof>>;
+
+template
+class ChaffTwoWatchedLiterals<GraspTwlImplementation<int16_t, CountingStatistics, NoProof>>;
+
+template
+class ChaffTwoWatchedLiterals<GraspTwlImplementation<int16_t, CountingStatistics, DratProof>>;
+
+template
+class ChaffTwoWatchedLiterals<GraspTwlImplementation<int32_t, NoStatistics, NoProof>>;
 
+template
+class ChaffTwoWatchedLiterals<GraspTwlImplementation<int32_t, NoStatistics, DratProof>>;
 
+template
+class ChaffTwoWatchedLiterals<GraspTwlImplementation<int32_t, CountingStatistics, NoProof>>;
 
+template
+class ChaffTwoWatchedLiterals<GraspTwlImplementation<int32_t, CountingStatistics, DratProof>>;
@@ -1,54 +1,95 @@
 #ifndef FREAKSATSOLVER_CHAFFTWOWATCHEDLITERALS_HXX
 #define FREAKSATSOLVER_CHAFFTWOWATCHEDLITERALS_HXX
 
-#include <unordered_map>
-#include "Solver.hxx"
-
-class GraspTwlImplementation;
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "Variable.hxx"
 
 /**
- * Two watched literals. Clause oblivious.
+ * Two watched literals. Clause oblivious. Watches clauses of @c Engine (GraspTwlImplementation instantiation), first
+ * two literals of every clause are watched. Watches survive backtracking as long as assignments are undone in reverse
+ * order, so structure lives as long as engine.
  */
+template<typename Engine>
 class ChaffTwoWatchedLiterals
 {
-    struct LiteralInClause
-    {
-        unsigned clauseIdx;
-        unsigned literalIdx;
-    };
-
-    struct ClauseInfo
-    {
-        unsigned literalIdx[2];
-        unsigned unknownPoolBegin;
-    };
+    std::vector<std::vector<unsigned>> watches; // literal -> clauses watching it
+    std::vector<unsigned> *watchesOf;           // watches shifted such that watchesOf[l] belongs to literal l
 
-    typedef Solver::Literal Literal;
+    Engine &dpllUpImplementation;
 
-    std::unordered_multimap<Literal, LiteralInClause> twl;
-    std::vector<ClauseInfo> clausesInfo;
+public:
+    static constexpr unsigned noConflict = ~0u;
 
-    Solver &satInstance;
-    GraspTwlImplementation &dpllUpImplementation;
+    /**
+     * Constructs TWL data structure for all clauses of @c dpllUpImplementation with at least two literals
+     */
+    ChaffTwoWatchedLiterals(Engine &dpllUpImplementation);
 
-    typedef std::unordered_multimap<Literal, LiteralInClause>::iterator LiteralInClauseHandle;
-    typedef std::pair<LiteralInClauseHandle, LiteralInClauseHandle> ClausesRange;
+    ChaffTwoWatchedLiterals(const ChaffTwoWatchedLiterals &) = delete;
 
-
-public:
+    ChaffTwoWatchedLiterals &operator=(const ChaffTwoWatchedLiterals &) = delete;
 
     /**
-     * Constructs TWL data structure for all non-unit clauses of @c satInstance
+     * Starts watching first two literals of clause. Clause has to contain at least two literals.
      */
-    ChaffTwoWatchedLiterals(Solver &satInstance, GraspTwlImplementation &dpllUpImplementation);
+    void watchClause(unsigned clauseIdx);
 
     /**
-     * Returns collection of clauses with watched @c l
+     * Rebuilds watches after clauses were removed
      */
-    ClausesRange watchedOccurrences(Literal l);
+    void reset();
 
-    Literal literalIsGoingToNegative(LiteralInClauseHandle clause);
+    /**
+     * @c l has been made false. Moves watches away from @c l, calls @c onUnit(literal, clauseIdx) for every clause
+     * which became unit. Returns index of clause which became empty or noConflict.
+     */
+    template<typename Literal, typename OnUnit>
+    unsigned literalIsGoingToNegative(Literal l, OnUnit onUnit);
 };
 
+template<typename Engine>
+template<typename Literal, typename OnUnit>
+unsigned ChaffTwoWatchedLiterals<Engine>::literalIsGoingToNegative(Literal l, OnUnit onUnit)
+{
+    auto &formula = dpllUpImplementation.formula;
+    auto &list = watchesOf[l];
+    size_t i = 0, j = 0;
+    for (; i < list.size(); ++i) {
+        auto clauseIdx = list[i];
+        auto &clause = formula[clauseIdx];
+        if (clause[0] == l) {
+            std::swap(clause[0], clause[1]); // watch going to negative is always second
+        }
+        if (dpllUpImplementation.literalValue(clause[0]) == Variable::POSITIVE) {
+            list[j++] = clauseIdx;
+            continue;
+        }
+        size_t k = 2;
+        while (k < clause.size() && dpllUpImplementation.literalValue(clause[k]) == Variable::NEGATIVE) {
+            ++k;
+        }
+        if (k < clause.size()) {
+            std::swap(clause[1], clause[k]);
+            watchesOf[clause[1]].push_back(clauseIdx);
+            continue;
+        }
+        list[j++] = clauseIdx;
+        if (dpllUpImplementation.literalValue(clause[0]) == Variable::NEGATIVE) {
+            // C is effectively an empty clause
+            for (++i; i < list.size(); ++i) {
+                list[j++] = list[i];
+            }
+            list.resize(j);
+            return clauseIdx;
+        }
+        // C is effectively unit
+        onUnit(clause[0], clauseIdx);
+    }
+    list.resize(j);
+    return noConflict;
+}
+
 
 #endif //FREAKSATSOLVER_CHAFFTWOWATCHEDLITERALS_HXX
@@ -0,0 +1,211 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <fcntl.h>
+#include <unistd.h>
+#include "Checkpoint.hxx"
+#include "CheckpointFormatException.hxx"
+
+using namespace std;
+
+constexpr char Checkpoint::magic[8];
+constexpr uint32_t Checkpoint::version;
+
+/**
+ * FNV-1a over 32-bit words, @c size is multiple of 4
+ */
+static uint64_t checksum(const char *data, size_t size)
+{
+    constexpr uint64_t prime = 1099511628211ull;
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i += sizeof(uint32_t)) {
+        uint32_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    return hash;
+}
+
+static size_t phasesSize(int32_t nbVariables)
+{
+    return (nbVariables + 1 + 3) / 4 * 4;
+}
+
+bool Checkpoint::read(const std::string &path)
+{
+    ifstream in(path, ios::binary);
+    if (!in) {
+        return false;
+    }
+    string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    Header header;
+    if (data.size() < sizeof(header)) {
+        throw CheckpointFormatException("Truncated checkpoint header");
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        throw CheckpointFormatException("Not a checkpoint: >" + path + "<");
+    }
+    if (header.version != version) {
+        throw CheckpointFormatException("Unsupported checkpoint version: " + to_string(header.version));
+    }
+    if (header.nbVariables < 0 || header.nbLiterals >= data.size() ||
+        data.size() != sizeof(header) + (header.nbVariables + 1) * sizeof(uint32_t) +
+                       header.nbVariables * sizeof(int32_t) + header.nbLiterals * sizeof(int32_t) +
+                       phasesSize(header.nbVariables)) {
+        throw CheckpointFormatException("Checkpoint size does not match header");
+    }
+    if (checksum(data.data() + sizeof(header), data.size() - sizeof(header)) != header.checksum) {
+        throw CheckpointFormatException("Checkpoint checksum mismatch");
+    }
+    memcpy(formulaHash, header.formulaHash, sizeof(formulaHash));
+    nbVariables = header.nbVariables;
+    statistics = Statistics();
+    statistics.decisions = header.statistics[0];
+    statistics.conflicts = header.statistics[1];
+    statistics.propagations = header.statistics[2];
+    statistics.restarts = header.statistics[3];
+    statistics.learnedClauses = header.statistics[4];
+    conflicts = header.conflicts;
+    modeLength = header.modeLength;
+    rephaseCount = header.rephaseCount;
+    stable = header.stable != 0;
+    auto position = data.data() + sizeof(header);
+    activities.resize(nbVariables + 1);
+    memcpy(activities.data(), position, activities.size() * sizeof(uint32_t));
+    position += activities.size() * sizeof(uint32_t);
+    queueOrder.resize(nbVariables);
+    memcpy(queueOrder.data(), position, queueOrder.size() * sizeof(int32_t));
+    position += queueOrder.size() * sizeof(int32_t);
+    clauses.resize(header.nbLiterals);
+    memcpy(clauses.data(), position, clauses.size() * sizeof(int32_t));
+    position += clauses.size() * sizeof(int32_t);
+    phases.resize(nbVariables + 1);
+    for (auto &phase : phases) {
+        phase = *position++ ? Variable::POSITIVE : Variable::NEGATIVE;
+    }
+
+    vector<bool> queued(nbVariables + 1);
+    for (auto v : queueOrder) {
+        if (v < 1 || v > nbVariables || queued[v]) {
+            throw CheckpointFormatException("Checkpoint VMTF order is not permutation of variables");
+        }
+        queued[v] = true;
+    }
+    for (auto l : clauses) {
+        if (l < -nbVariables || l > nbVariables) {
+            throw CheckpointFormatException("Checkpoint literal out of range: " + to_string(l));
+        }
+    }
+    if (!clauses.empty() && clauses.back() != 0) {
+        throw CheckpointFormatException("Checkpoint clause is not terminated");
+    }
+    return true;
+}
+
+std::string Checkpoint::serialize() const
+{
+    Header header = {};
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.nbVariables = nbVariables;
+    memcpy(header.formulaHash, formulaHash, sizeof(formulaHash));
+    header.statistics[0] = statistics.decisions;
+    header.statistics[1] = statistics.conflicts;
+    header.statistics[2] = statistics.propagations;
+    header.statistics[3] = statistics.restarts;
+    header.statistics[4] = statistics.learnedClauses;
+    header.conflicts = conflicts;
+    header.modeLength = modeLength;
+    header.rephaseCount = rephaseCount;
+    header.stable = stable;
+    header.nbLiterals = clauses.size();
+    string data(sizeof(header), '\0');
+    data.append(reinterpret_cast<const char *>(activities.data()), activities.size() * sizeof(uint32_t));
+    data.append(reinterpret_cast<const char *>(queueOrder.data()), queueOrder.size() * sizeof(int32_t));
+    data.append(reinterpret_cast<const char *>(clauses.data()), clauses.size() * sizeof(int32_t));
+    for (auto phase : phases) {
+        data.push_back(phase == Variable::POSITIVE);
+    }
+    data.resize(data.size() + phasesSize(nbVariables) - phases.size(), '\0');
+    header.checksum = checksum(data.data() + sizeof(header), data.size() - sizeof(header));
+    memcpy(&data[0], &header, sizeof(header));
+    return data;
+}
+
+CheckpointWriter::CheckpointWriter(const std::string &path) : path(path),
+                                                              writer(&CheckpointWriter::work, this)
+{ }
+
+CheckpointWriter::~CheckpointWriter()
+{
+    {
+        lock_guard<mutex> lock(stateMutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    writer.join();
+}
+
+void CheckpointWriter::submit(std::string data)
+{
+    {
+        lock_guard<mutex> lock(stateMutex);
+        pending = move(data);
+        hasPending = true;
+    }
+    changed.notify_all();
+}
+
+void CheckpointWriter::flush()
+{
+    unique_lock<mutex> lock(stateMutex);
+    changed.wait(lock, [this]() { return !hasPending && !writing; });
+}
+
+void CheckpointWriter::work()
+{
+    string data;
+    unique_lock<mutex> lock(stateMutex);
+    for (;;) {
+        changed.wait(lock, [this]() { return hasPending || stopping; });
+        if (!hasPending) {
+            return;
+        }
+        swap(data, pending);
+        hasPending = false;
+        writing = true;
+        lock.unlock();
+        write(data);
+        lock.lock();
+        writing = false;
+        changed.notify_all();
+    }
+}
+
+void CheckpointWriter::write(const std::string &data)
+{
+    // writer thread has nobody to throw to, failed checkpoint only costs progress
+    string temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool written = fd >= 0;
+    for (size_t offset = 0; written && offset < data.size();) {
+        auto result = ::write(fd, data.data() + offset, data.size() - offset);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        written = result > 0;
+        offset += written ? result : 0;
+    }
+    written = written && fsync(fd) == 0;
+    if (fd >= 0) {
+        written = close(fd) == 0 && written;
+    }
+    if (!written || rename(temporary.c_str(), path.c_str()) != 0) {
+        cerr << "c unable to write checkpoint >" << path << "<: " << strerror(errno) << '\n';
+        unlink(temporary.c_str());
+    }
+}
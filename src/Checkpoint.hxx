@@ -0,0 +1,108 @@
+#ifndef FREAKSATSOLVER_CHECKPOINT_HXX
+#define FREAKSATSOLVER_CHECKPOINT_HXX
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Variable.hxx"
+#include "Statistics.hxx"
+
+/**
+ * Search state of CDCL engine which survives process restart: learned clauses, activities, saved phases, VMTF order,
+ * search schedule and statistics. Binary layout (native byte order):
+ * header, uint32 activities [nbVariables + 1], int32 VMTF order [nbVariables] (first to last bumped),
+ * int32 literals of clauses each terminated by 0 [nbLiterals], uint8 phases [nbVariables + 1] padded to 4 bytes.
+ * Checksum covers everything after header.
+ */
+struct Checkpoint
+{
+    struct Header
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::int32_t nbVariables;
+        std::uint64_t formulaHash[2];         // ResultCache::formulaKey of instance
+        std::uint64_t statistics[5];          // decisions, conflicts, propagations, restarts, learned clauses
+        std::uint64_t conflicts;
+        std::uint64_t modeLength;
+        std::uint32_t rephaseCount;
+        std::uint32_t stable;
+        std::uint64_t nbLiterals;
+        std::uint64_t checksum;
+    };
+
+    static constexpr char magic[8] = {'F', 'S', 'A', 'T', 'C', 'K', 'P', 'T'};
+    static constexpr std::uint32_t version = 1;
+
+    std::uint64_t formulaHash[2];
+    std::int32_t nbVariables;
+    Statistics statistics;
+    unsigned long long conflicts;
+    unsigned long long modeLength;
+    unsigned rephaseCount;
+    bool stable;
+    std::vector<std::uint32_t> activities;
+    std::vector<std::int32_t> queueOrder;
+    std::vector<std::int32_t> clauses; // literals, 0 ends clause
+    std::vector<Variable> phases;
+
+    /**
+     * Loads checkpoint from @c path. Returns false if file does not exist, throws CheckpointFormatException if it is
+     * corrupted.
+     */
+    bool read(const std::string &path);
+
+    /**
+     * Binary representation written by @c CheckpointWriter
+     */
+    std::string serialize() const;
+};
+
+/**
+ * Writes checkpoints on background thread, search continues while previous state goes to disk. File is replaced
+ * atomically (written to PATH.tmp, synced and renamed), so crash never leaves truncated checkpoint.
+ */
+class CheckpointWriter
+{
+    std::string path;
+    std::mutex stateMutex;
+    std::condition_variable changed;
+    std::string pending;     // serialized checkpoint waiting for writer
+    bool hasPending = false;
+    bool writing = false;
+    bool stopping = false;
+    std::thread writer;
+
+public:
+    explicit CheckpointWriter(const std::string &path);
+
+    CheckpointWriter(const CheckpointWriter &) = delete;
+
+    CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+    /**
+     * Writes pending checkpoint before returning
+     */
+    ~CheckpointWriter();
+
+    /**
+     * Schedules write of @c data, replaces checkpoint still waiting for writer
+     */
+    void submit(std::string data);
+
+    /**
+     * Blocks until submitted checkpoint is on disk
+     */
+    void flush();
+
+private:
+    void work();
+
+    void write(const std::string &data);
+};
+
+
+#endif //FREAKSATSOLVER_CHECKPOINT_HXX
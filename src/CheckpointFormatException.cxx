@@ -0,0 +1 @@
+#include "CheckpointFormatException.hxx"
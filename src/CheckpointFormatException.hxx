@@ -0,0 +1,15 @@
+#ifndef FREAKSATSOLVER_CHECKPOINTFORMATEXCEPTION_HXX
+#define FREAKSATSOLVER_CHECKPOINTFORMATEXCEPTION_HXX
+
+#include <stdexcept>
+
+/**
+ * Signals corrupted or incompatible solver checkpoint
+ */
+class CheckpointFormatException : public std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+
+#endif //FREAKSATSOLVER_CHECKPOINTFORMATEXCEPTION_HXX
@@ -0,0 +1,168 @@
+#include <cassert>
+#include <cstdlib>
+#include <algorithm>
+#include "ComponentDecomposition.hxx"
+
+using namespace std;
+
+ComponentDecomposition::ComponentDecomposition(const Solver &satInstance, bool simplify) : fixed(
+        satInstance.nbVariables + 1, Variable::UNKNOWN), parent(satInstance.nbVariables + 1), componentSize(
+        satInstance.nbVariables + 1, 1)
+{
+    Formula simplified;
+    const Formula &formula = simplify ? (simplified = propagateUnits(satInstance.formula)) : satInstance.formula;
+    if (unsatisfiable) {
+        return;
+    }
+    for (Literal i = 0; i <= satInstance.nbVariables; ++i) {
+        parent[i] = i;
+    }
+    for (auto &clause : formula) {
+        if (clause.empty()) {
+            unsatisfiable = true;
+            return;
+        }
+        for (size_t i = 1; i < clause.size(); ++i) {
+            unite(abs(clause[0]), abs(clause[i]));
+        }
+    }
+
+    // variables occurring in no clause form no component
+    vector<bool> used(satInstance.nbVariables + 1);
+    for (auto &clause : formula) {
+        for (auto l : clause) {
+            used[abs(l)] = true;
+        }
+    }
+    vector<unsigned> componentOfRoot(satInstance.nbVariables + 1);
+    vector<Literal> localIndex(satInstance.nbVariables + 1);
+    for (Literal i = 1; i <= satInstance.nbVariables; ++i) {
+        if (!used[i]) {
+            continue;
+        }
+        auto root = find(i);
+        if (root == i) {
+            componentOfRoot[root] = components.size();
+            components.emplace_back();
+            components.back().variables.reserve(componentSize[root]);
+        }
+    }
+    for (Literal i = 1; i <= satInstance.nbVariables; ++i) {
+        if (used[i]) {
+            auto &component = components[componentOfRoot[find(i)]];
+            component.variables.push_back(i);
+            localIndex[i] = component.variables.size();
+        }
+    }
+    for (auto &clause : formula) {
+        auto &component = components[componentOfRoot[find(abs(clause[0]))]];
+        component.formula.emplace_back();
+        component.formula.back().reserve(clause.size());
+        for (auto l : clause) {
+            component.formula.back().push_back(l > 0 ? localIndex[l] : -localIndex[-l]);
+        }
+    }
+    sort(components.begin(), components.end(), [](const Component &a, const Component &b) {
+        return a.formula.size() > b.formula.size();
+    });
+}
+
+bool ComponentDecomposition::isUnsatisfiable() const
+{
+    return unsatisfiable;
+}
+
+const vector<Variable> &ComponentDecomposition::getFixedVariables() const
+{
+    return fixed;
+}
+
+vector<ComponentDecomposition::Component> &ComponentDecomposition::getComponents()
+{
+    return components;
+}
+
+ComponentDecomposition::Formula ComponentDecomposition::propagateUnits(const Formula &formula)
+{
+    for (bool assignmentChanged = true; assignmentChanged && !unsatisfiable;) {
+        assignmentChanged = false;
+        for (auto &clause : formula) {
+            Literal unassigned = 0;
+            unsigned unassignedCount = 0;
+            bool satisfied = false;
+            for (auto l : clause) {
+                auto value = literalValue(l);
+                if (value == Variable::POSITIVE) {
+                    satisfied = true;
+                    break;
+                } else if (value == Variable::UNKNOWN) {
+                    unassigned = l;
+                    unassignedCount += 1;
+                }
+            }
+            if (satisfied || unassignedCount > 1) {
+                continue;
+            }
+            if (unassignedCount == 0) {
+                unsatisfiable = true;
+                break;
+            }
+            fixed[abs(unassigned)] = unassigned > 0 ? Variable::POSITIVE : Variable::NEGATIVE;
+            assignmentChanged = true;
+        }
+    }
+    Formula result;
+    if (unsatisfiable) {
+        return result;
+    }
+    for (auto &clause : formula) {
+        Clause reduced;
+        bool satisfied = false;
+        for (auto l : clause) {
+            auto value = literalValue(l);
+            if (value == Variable::POSITIVE) {
+                satisfied = true;
+                break;
+            } else if (value == Variable::UNKNOWN) {
+                reduced.push_back(l);
+            }
+        }
+        if (!satisfied) {
+            assert(reduced.size() >= 2);
+            result.push_back(move(reduced));
+        }
+    }
+    return result;
+}
+
+ComponentDecomposition::Literal ComponentDecomposition::find(Literal variable)
+{
+    while (parent[variable] != variable) {
+        parent[variable] = parent[parent[variable]]; // path halving
+        variable = parent[variable];
+    }
+    return variable;
+}
+
+void ComponentDecomposition::unite(Literal a, Literal b)
+{
+    a = find(a);
+    b = find(b);
+    if (a == b) {
+        return;
+    }
+    if (componentSize[a] < componentSize[b]) {
+        swap(a, b);
+    }
+    parent[b] = a;
+    componentSize[a] += componentSize[b];
+}
+
+Variable ComponentDecomposition::literalValue(Literal l) const
+{
+    Variable value = fixed[abs(l)];
+    if (l < 0 && value != Variable::UNKNOWN) {
+        value = value == Variable::POSITIVE ? Variable::NEGATIVE : Variable::POSITIVE;
+    }
+    return value;
+}
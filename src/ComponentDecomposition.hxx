@@ -0,0 +1,65 @@
+#ifndef FREAKSATSOLVER_COMPONENTDECOMPOSITION_HXX
+#define FREAKSATSOLVER_COMPONENTDECOMPOSITION_HXX
+
+#include <vector>
+#include "Variable.hxx"
+#include "Solver.hxx"
+
+/**
+ * Splits formula into subformulas which share no variables (union-find over variables of each clause). Optionally
+ * unit propagation at level 0 is performed first, which removes satisfied clauses and false literals and may split
+ * formula further.
+ */
+class ComponentDecomposition
+{
+    typedef Solver::Literal Literal;
+    typedef Solver::Clause Clause;
+    typedef Solver::Formula Formula;
+
+public:
+    struct Component
+    {
+        std::vector<Literal> variables; // variable of component (numbered from 1) -> variable of original formula
+        Formula formula;                // clauses over variables of component
+    };
+
+private:
+    std::vector<Variable> fixed;        // variable -> value assigned at level 0 or UNKNOWN
+    std::vector<Literal> parent;        // union-find forest over variables
+    std::vector<Literal> componentSize;
+    std::vector<Component> components;
+    bool unsatisfiable = false;
+
+public:
+    ComponentDecomposition(const Solver &satInstance, bool simplify);
+
+    /**
+     * Level 0 simplification derived empty clause
+     */
+    bool isUnsatisfiable() const;
+
+    /**
+     * Values of variables fixed by level 0 simplification
+     */
+    const std::vector<Variable> &getFixedVariables() const;
+
+    /**
+     * Components ordered from the largest one
+     */
+    std::vector<Component> &getComponents();
+
+private:
+    /**
+     * Unit propagation at level 0. Returns simplified formula.
+     */
+    Formula propagateUnits(const Formula &formula);
+
+    Literal find(Literal variable);
+
+    void unite(Literal a, Literal b);
+
+    Variable literalValue(Literal l) const;
+};
+
+
+#endif //FREAKSATSOLVER_COMPONENTDECOMPOSITION_HXX
@@ -1,223 +1,205 @@
 #include <cassert>
-#include <stack>
-#include <queue>
+#include <cstdlib>
+#include <algorithm>
 #include "DpllUpImplementation.hxx"
 #include "Solver.hxx"
-#include "TwoWatchedLiterals.hxx"
 
 using namespace std;
 
 DpllUpImplementation::DpllUpImplementation(Solver &satInstance) : satInstance(satInstance),
-                                                                  model(satInstance.nbVariables + 1, Variable::UNKNOWN)
-{ }
-
-
-SolverResult DpllUpImplementation::trySolve()
+                                                                  model(satInstance.nbVariables + 1,
+                                                                        Variable::UNKNOWN),
+                                                                  watches(2 * (satInstance.nbVariables + 1)),
+                                                                  freeVariables(satInstance.nbVariables),
+                                                                  freePosition(satInstance.nbVariables + 1),
+                                                                  nbFree(satInstance.nbVariables),
+                                                                  phase(satInstance.nbVariables + 1),
+                                                                  budget(satInstance.options.limits,
+                                                                         satInstance.options.cancellation)
 {
-    unordered_set<Literal> variablesToBeAssigned;
-    for (Literal i = 1; i <= satInstance.nbVariables; ++i)
-        variablesToBeAssigned.insert(i);
-    return solveSat(variablesToBeAssigned) ? SolverResult::SAT : SolverResult::UNSAT;
+    // flat deduplicated copy of formula, tautologies are always satisfied and dropped
+    vector<char> seen(2 * (satInstance.nbVariables + 1));
+    vector<unsigned> occurrences(2 * (satInstance.nbVariables + 1));
+    clauseBegin.push_back(0);
+    for (auto &clause : satInstance.formula) {
+        auto begin = literals.size();
+        bool tautology = false;
+        for (auto l : clause) {
+            if (seen[literalIndex(-l)]) {
+                tautology = true;
+            }
+            if (!seen[literalIndex(l)]) {
+                seen[literalIndex(l)] = 1;
+                literals.push_back(l);
+            }
+        }
+        for (auto i = begin; i < literals.size(); ++i) {
+            seen[literalIndex(literals[i])] = 0;
+        }
+        if (tautology || literals.size() - begin < 2) {
+            hasEmptyClause = hasEmptyClause || (!tautology && literals.size() == begin);
+            if (!tautology && literals.size() == begin + 1) {
+                units.push_back(literals[begin]);
+            }
+            literals.resize(begin);
+            continue;
+        }
+        for (auto i = begin; i < literals.size(); ++i) {
+            occurrences[literalIndex(literals[i])] += 1;
+        }
+        watches[literalIndex(literals[begin])].push_back(clauseBegin.size() - 1);
+        watches[literalIndex(literals[begin + 1])].push_back(clauseBegin.size() - 1);
+        clauseBegin.push_back(literals.size());
+    }
+    trail.reserve(satInstance.nbVariables);
+    decisions.reserve(satInstance.nbVariables);
+
+    // most occurring variables are decided first, each of them in its more occurring phase
+    for (Literal v = 1; v <= satInstance.nbVariables; ++v) {
+        freeVariables[v - 1] = v;
+        phase[v] = occurrences[literalIndex(-v)] > occurrences[literalIndex(v)] ? -v : v;
+    }
+    stable_sort(freeVariables.begin(), freeVariables.end(), [&occurrences](Literal a, Literal b) {
+        return occurrences[literalIndex(a)] + occurrences[literalIndex(-a)] <
+               occurrences[literalIndex(b)] + occurrences[literalIndex(-b)];
+    });
+    for (unsigned i = 0; i < freeVariables.size(); ++i) {
+        freePosition[freeVariables[i]] = i;
+    }
 }
 
-bool DpllUpImplementation::solveSat(std::unordered_set<Literal> &variablesToBeAssigned)
+SolverResult DpllUpImplementation::trySolve()
 {
-    if (variablesToBeAssigned.empty()) {
-        return isModelOfSatInstance();
+    if (hasEmptyClause) {
+        return SolverResult::UNSAT;
     }
-    Literal choosenVariable = *variablesToBeAssigned.begin();
-    variablesToBeAssigned.erase(variablesToBeAssigned.begin());
-    vector<Literal> upResult = propagateLiteral(choosenVariable);
-    if (!upResult.empty()) {
-        for (Literal l : upResult) {
-            assert(model[abs(l)] == (l > 0 ? Variable::POSITIVE : Variable::NEGATIVE));
-            variablesToBeAssigned.erase(abs(l));
+    for (auto l : units) {
+        auto value = literalValue(l);
+        if (value == Variable::NEGATIVE) {
+            return SolverResult::UNSAT;
+        } else if (value == Variable::UNKNOWN) {
+            assign(l);
         }
-        if (solveSat(variablesToBeAssigned)) {
-            return true;
+    }
+    for (;;) {
+        if (!propagate()) {
+            statistics.conflicts += 1;
+            // both phases of later decisions failed under this one
+            while (!decisions.empty() && decisions.back().flipped) {
+                decisions.pop_back();
+            }
+            if (decisions.empty()) {
+                return SolverResult::UNSAT;
+            }
+            auto &decision = decisions.back();
+            undo(decision.marker);
+            decision.flipped = true;
+            decision.literal = -decision.literal;
+            assign(decision.literal);
+            continue;
         }
-        // rollback, memento in future
-        for (Literal l : upResult) {
-            assert(model[abs(l)] != Variable::UNKNOWN);
-            model[abs(l)] = Variable::UNKNOWN;
-            variablesToBeAssigned.insert(abs(l));
+        if (budget.isExhausted(statistics)) {
+            return SolverResult::UNKNOWN;
         }
-    }
-    upResult = propagateLiteral(-choosenVariable);
-    if (upResult.empty()) {
-        return false;
-    }
-    for (Literal l : upResult) {
-        assert(model[abs(l)] == (l > 0 ? Variable::POSITIVE : Variable::NEGATIVE));
-        variablesToBeAssigned.erase(abs(l));
-    }
-    if (solveSat(variablesToBeAssigned)) {
-        return true;
-    } else {
-        // rollback, memento in future
-        for (Literal l : upResult) {
-            assert(model[abs(l)] != Variable::UNKNOWN);
-            model[abs(l)] = Variable::UNKNOWN;
-            variablesToBeAssigned.insert(abs(l));
+        if (nbFree == 0) {
+            return SolverResult::SAT;
         }
-        return false;
+        statistics.decisions += 1;
+        auto literal = phase[freeVariables[nbFree - 1]];
+        decisions.push_back({trail.size(), literal, false});
+        assign(literal);
     }
 }
 
-vector<DpllUpImplementation::Literal> DpllUpImplementation::propagateLiteral(Literal literal)
+bool DpllUpImplementation::propagate()
 {
-    queue<Literal> Q;
-    vector<Literal> result;
-    result.push_back(literal);
-    setLiteral(literal);
-    for (auto clause : satInstance.formula) {
-        if (Literal l = isUnit(clause)) {
-            if (literalValue(l) != Variable::UNKNOWN) {
-                // failed - rollback
-                for (Literal ll : result) {
-                    purgeLiteral(ll);
-                }
-                return {};
+    for (; propagated < trail.size(); ++propagated) {
+        Literal falsified = -trail[propagated];
+        auto &watching = watches[literalIndex(falsified)];
+        size_t kept = 0;
+        for (size_t i = 0; i < watching.size(); ++i) {
+            auto clause = &literals[clauseBegin[watching[i]]];
+            auto end = &literals[0] + clauseBegin[watching[i] + 1];
+            if (clause[0] == falsified) {
+                swap(clause[0], clause[1]);
             }
-            result.push_back(l);
-            setLiteral(l);
-        }
-    }
-    TwoWatchedLiterals twl(satInstance, *this);
-    while (!Q.empty()) {
-        Literal l = Q.front();
-        Q.pop();
-        auto range = twl.watchedOccurrences(-l);
-        for (auto clause = range.first; clause != range.second; ++clause) {
-            // We were watching -l in clause, but -l has been made false
-            Literal h = twl.literalIsGoingToNegative(clause);
-            if (h) {
-                Variable v = literalValue(h);
-                if (v == Variable::NEGATIVE) {
-                    // C is effectively an empty clause
-                    // failed - rollback
-                    for (Literal ll : result) {
-                        purgeLiteral(ll);
-                    }
-                    return {};
-                } else {
-                    // C is effectively unit
-                    if (v != Variable::POSITIVE) {
-                        result.push_back(h);
-                        setLiteral(h);
-                        Q.push(h);
-                    }
+            if (literalValue(clause[0]) == Variable::POSITIVE) {
+                watching[kept++] = watching[i];
+                continue;
+            }
+            auto replacement = find_if(clause + 2, end, [this](Literal l) {
+                return literalValue(l) != Variable::NEGATIVE;
+            });
+            if (replacement != end) {
+                swap(clause[1], *replacement);
+                watches[literalIndex(clause[1])].push_back(watching[i]);
+                continue;
+            }
+            watching[kept++] = watching[i];
+            if (literalValue(clause[0]) == Variable::NEGATIVE) {
+                // watches not visited yet stay
+                for (++i; i < watching.size(); ++i) {
+                    watching[kept++] = watching[i];
                 }
+                watching.resize(kept);
+                return false;
             }
+            assign(clause[0]);
+            statistics.propagations += 1;
         }
+        watching.resize(kept);
     }
-    return result;
+    return true;
 }
 
-const vector<Variable> DpllUpImplementation::getModel() const
+void DpllUpImplementation::assign(Literal l)
 {
-    return model;
+    model[abs(l)] = l > 0 ? Variable::POSITIVE : Variable::NEGATIVE;
+    trail.push_back(l);
+    // swap with last unassigned variable
+    auto position = freePosition[abs(l)];
+    auto last = freeVariables[--nbFree];
+    freeVariables[position] = last;
+    freePosition[last] = position;
+    freeVariables[nbFree] = abs(l);
+    freePosition[abs(l)] = nbFree;
 }
 
-Variable DpllUpImplementation::literalValue(Literal l) const
+void DpllUpImplementation::undo(std::size_t marker)
 {
-    bool needNegation = l < 0;
-    if (needNegation) {
-        l = -l;
-    }
-    Variable result = model[l];
-    if (needNegation) {
-        if (result == Variable::NEGATIVE) {
-            result = Variable::POSITIVE;
-        } else if (result == Variable::POSITIVE) {
-            result = Variable::NEGATIVE;
-        }
+    for (auto l = trail.begin() + marker; l != trail.end(); ++l) {
+        model[abs(*l)] = Variable::UNKNOWN;
     }
-    return result;
+    nbFree += trail.size() - marker;
+    trail.resize(marker);
+    propagated = marker;
 }
 
-DpllUpImplementation::Literal DpllUpImplementation::isUnit(ClauseRepresentation &clause)
+const vector<Variable> DpllUpImplementation::getModel() const
 {
-    Literal result[2];
-    unsigned resultsCount = 0;
-    for (auto l : clause) {
-        auto value = literalValue(l);
-        if (value == Variable::POSITIVE) {
-            return 0;   // this clause does not exist - so it is not an unit clause
-        } else if (value == Variable::NEGATIVE) {
-            // skip - this literal does not exist
-        } else {
-            assert(value == Variable::UNKNOWN);
-            result[resultsCount++] = l;
-            if (resultsCount == 2) {
-                return 0; // this is not an unit clause
-            }
-        }
-    }
-    assert(resultsCount < 2);
-    if (resultsCount == 0) {
-        return 0; // this is empty clause in fact - not unit
-    } else {
-        return result[0];
-    }
+    return model;
 }
 
-void DpllUpImplementation::setLiteral(Literal l)
+const Statistics &DpllUpImplementation::getStatistics() const
 {
-    if (l > 0) {
-        model[l] = Variable::POSITIVE;
-    } else {
-        assert(l < 0);
-        model[-l] = Variable::NEGATIVE;
-    }
+    return statistics;
 }
 
-void DpllUpImplementation::purgeLiteral(Literal l)
+const char *DpllUpImplementation::getExhaustedResource() const
 {
-    model[abs(l)] = Variable::UNKNOWN;
+    return budget.getExhaustedResource();
 }
 
-bool DpllUpImplementation::isModelOfSatInstance() const
+Variable DpllUpImplementation::literalValue(Literal l) const
 {
-    for (auto clause : satInstance.formula) {
-        bool clauseIsPositive = false;
-        for (auto literal : clause) {
-            if ((literal < 0 && model[-literal] == Variable::NEGATIVE) ||
-                (literal > 0 && model[literal] == Variable::POSITIVE)) {
-                clauseIsPositive = true;
-                break;
-            }
-        }
-        if (!clauseIsPositive) {
-            return false;
-        }
+    Variable value = model[abs(l)];
+    if (l < 0 && value != Variable::UNKNOWN) {
+        value = value == Variable::POSITIVE ? Variable::NEGATIVE : Variable::POSITIVE;
     }
-    return true;
+    return value;
 }
 
-SolverResult DpllUpImplementation::canBeModelOfSatInstance() const
+size_t DpllUpImplementation::literalIndex(Literal l)
 {
-    bool formulaIsPositive = true;
-    for (auto clause : satInstance.formula) {
-        bool clauseIsPositive = false;
-        bool clauseMayBePositive = false;
-        for (auto literal : clause) {
-            if ((literal < 0 && model[-literal] == Variable::NEGATIVE) ||
-                (literal > 0 && model[literal] == Variable::POSITIVE)) {
-                clauseIsPositive = true;
-                break;
-            } else if ((literal < 0 && model[-literal] == Variable::UNKNOWN) ||
-                       (literal > 0 && model[literal] == Variable::UNKNOWN)) {
-                clauseMayBePositive = true;
-            }
-        }
-        if (!clauseIsPositive && !clauseMayBePositive) {
-            return SolverResult::UNSAT;
-        }
-        if (!clauseIsPositive) {
-            assert(clauseMayBePositive);
-            formulaIsPositive = false;
-        }
-    }
-    return formulaIsPositive ? SolverResult::SAT : SolverResult::UNKNOWN;
+    return 2 * static_cast<size_t>(abs(l)) + (l < 0);
 }
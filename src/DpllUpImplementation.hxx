@@ -1,74 +1,92 @@
 #ifndef FREAKSATSOLVER_DPLLUPSOLVER_HXX
 #define FREAKSATSOLVER_DPLLUPSOLVER_HXX
 
+#include <cstddef>
 #include <vector>
-#include <unordered_set>
 #include "SolverResult.hxx"
 #include "Variable.hxx"
 #include "Solver.hxx"
+#include "Budget.hxx"
+#include "Statistics.hxx"
 
 class Solver;
 
 /**
- * This is DPLL with UP on TWL SAT Solver implementation.
+ * This is DPLL with UP on TWL SAT Solver implementation. Lightweight engine without learning: clauses are copied once
+ * into flat array, watches are kept across backtracking and search is iterative over trail of assigned literals with
+ * decision markers, so no memory is allocated while searching. Backtracking is chronological, it unassigns trail down
+ * to last decision whose opposite phase was not tried yet.
  */
 class DpllUpImplementation
 {
+    typedef Solver::Literal Literal; // NOTE type is from SAT instance, this class needs type of instance (template)
+
+    /**
+     * Decision, undone by unassigning trail from marker
+     */
+    struct Decision
+    {
+        std::size_t marker; // trail size before decision
+        Literal literal;
+        bool flipped;       // literal is opposite phase of decision, both phases tried
+    };
+
     Solver &satInstance;
     std::vector<Variable> model;
+    bool hasEmptyClause = false;
 
-    typedef Solver::Literal Literal; // NOTE type is from SAT instance, this class needs type of instance (template)
-    typedef Solver::Clause ClauseRepresentation;
+    std::vector<unsigned> clauseBegin; // clause -> begin of its literals in literals, one past end at the back
+    std::vector<Literal> literals;     // deduplicated clauses of two or more literals, first two are watched
+    std::vector<Literal> units;        // clauses of single literal
+    std::vector<std::vector<unsigned>> watches; // literal index -> clauses watching it, kept across backtracking
+
+    std::vector<Literal> trail;        // assigned literals in order
+    std::size_t propagated = 0;        // trail head, literals before it are propagated
+    std::vector<Decision> decisions;
+
+    // unassigned variables are freeVariables[0 .. nbFree - 1], assigned ones follow in reverse order of assignment,
+    // so unassigning trail backwards only grows nbFree
+    std::vector<Literal> freeVariables;
+    std::vector<unsigned> freePosition; // variable -> index in freeVariables
+    std::size_t nbFree;
+    std::vector<Literal> phase;         // variable -> literal decided first, more occurring one
 
-    friend class TwoWatchedLiterals;
+    Budget budget;
+    Statistics statistics;
 
 public:
     DpllUpImplementation(Solver &satInstance);
 
+    /**
+     * Searches until model is found, all assignments are refuted or budget runs out
+     */
     SolverResult trySolve();
 
     const std::vector<Variable> getModel() const;
 
-    Variable literalValue(Literal l) const;
+    const Statistics &getStatistics() const;
 
-private:
-
-    bool solveSat(std::unordered_set<Literal> &variablesToBeAssigned);
-
-    /**
-     * Unit propagation. Propagates @c literal, returns deduced truth assignment if success or empty vector on failure.
-     */
-    std::vector<Literal> propagateLiteral(Literal literal);
+    const char *getExhaustedResource() const;
 
+private:
     /**
-     * Returns literal if @c clause is literal or 0 if at least two non unknown literals exist
+     * Unit propagation of trail from @c propagated. Returns false on conflict.
      */
-    Literal isUnit(ClauseRepresentation &clause);
+    bool propagate();
 
     /**
-     * Modifies model in a way such that @c l is positive
+     * Modifies model in a way such that @c l is positive and appends it to trail
      */
-    void setLiteral(Literal l);
+    void assign(Literal l);
 
     /**
-     * Remove truth assignment from literal
+     * Unassigns literals of trail from @c marker on
      */
-    void purgeLiteral(Literal l);
+    void undo(std::size_t marker);
 
-    bool isModelOfSatInstance() const;
-
-    /**
-     * Checks if current model _can_ satisfy given SAT formula
-     */
-    SolverResult canBeModelOfSatInstance() const;
+    Variable literalValue(Literal l) const;
 
-    struct TrailNode
-    {
-        std::vector<Literal> truthAssignment; // assignment from single UP
-        std::vector<Literal> variablesToAssign; // all variables still to be assigned
-        Literal activeVariable; // variable given to UP
-        // TWL // copy, TODO memento pattern
-    };
+    static std::size_t literalIndex(Literal l);
 };
 
 
@@ -0,0 +1,148 @@
+#ifndef FREAKSATSOLVER_ENGINEPOLICIES_HXX
+#define FREAKSATSOLVER_ENGINEPOLICIES_HXX
+
+#include <fstream>
+#include <string>
+#include <stdexcept>
+#include "Statistics.hxx"
+#include "SolverOptions.hxx"
+
+/**
+ * Statistics policy which counts search events. Counters are needed by conflict and propagation budgets and are
+ * printed with UNKNOWN result.
+ */
+class CountingStatistics
+{
+    Statistics counters;
+
+public:
+    static constexpr bool counting = true;
+
+    void decision()
+    { counters.decisions += 1; }
+
+    void conflict()
+    { counters.conflicts += 1; }
+
+    void propagation()
+    { counters.propagations += 1; }
+
+    void restart()
+    { counters.restarts += 1; }
+
+    void learnedClause()
+    { counters.learnedClauses += 1; }
+
+    /**
+     * Continues counting from checkpoint
+     */
+    void restore(const Statistics &saved)
+    { counters = saved; }
+
+    const Statistics &get() const
+    { return counters; }
+};
+
+/**
+ * Statistics policy which counts nothing. Usable only when no limit is set (so counters are never consulted). Search
+ * may still end with UNKNOWN when cancelled, zero counters are not printed then.
+ */
+class NoStatistics
+{
+    Statistics counters; // stays zero
+
+public:
+    static constexpr bool counting = false;
+
+    void decision()
+    {}
+
+    void conflict()
+    {}
+
+    void propagation()
+    {}
+
+    void restart()
+    {}
+
+    void learnedClause()
+    {}
+
+    void restore(const Statistics &)
+    {}
+
+    const Statistics &get() const
+    { return counters; }
+};
+
+/**
+ * Proof policy which does not log anything
+ */
+struct NoProof
+{
+    explicit NoProof(const SolverOptions &)
+    {}
+
+    template<typename Clause>
+    void addClause(const Clause &)
+    {}
+
+    template<typename Clause>
+    void deleteClause(const Clause &)
+    {}
+};
+
+/**
+ * Proof policy which writes DRAT proof (text format) to @c SolverOptions::proofPath. Every learned clause is RUP, so
+ * proof of UNSAT instance ends with empty clause.
+ */
+class DratProof
+{
+    std::ofstream out;
+
+public:
+    explicit DratProof(const SolverOptions &options) : out(options.proofPath)
+    {
+        if (!out) {
+            throw std::runtime_error("Unable to open proof file >" + options.proofPath + "<");
+        }
+    }
+
+    template<typename Clause>
+    void addClause(const Clause &clause)
+    {
+        for (auto l : clause) {
+            out << static_cast<int>(l) << ' ';
+        }
+        out << "0\n";
+    }
+
+    template<typename Clause>
+    void deleteClause(const Clause &clause)
+    {
+        out << "d ";
+        addClause(clause);
+    }
+};
+
+/**
+ * Assertion policy enabling checks which cost more than the checked operation (e.g. scan of whole formula)
+ */
+struct CheckedAssertions
+{
+    static constexpr bool enabled = true;
+};
+
+struct UncheckedAssertions
+{
+    static constexpr bool enabled = false;
+};
+
+#ifdef NDEBUG
+typedef UncheckedAssertions DefaultAssertions;
+#else
+typedef CheckedAssertions DefaultAssertions;
+#endif
+
+#endif //FREAKSATSOLVER_ENGINEPOLICIES_HXX
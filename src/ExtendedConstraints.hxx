@@ -0,0 +1,46 @@
+#ifndef FREAKSATSOLVER_EXTENDEDCONSTRAINTS_HXX
+#define FREAKSATSOLVER_EXTENDEDCONSTRAINTS_HXX
+
+#include <vector>
+
+/**
+ * At most @c bound of @c literals are true. DIMACS line "k BOUND literals... 0".
+ */
+struct CardinalityConstraint
+{
+    std::vector<int> literals;
+    unsigned bound;
+};
+
+/**
+ * Sum of values of @c variables modulo 2 equals @c parity. DIMACS line "x literals... 0" states that exclusive or of
+ * literals is true, negative literal flips parity.
+ */
+struct XorConstraint
+{
+    std::vector<int> variables; // positive, no duplicates
+    bool parity;
+};
+
+/**
+ * Clause of weighted (MaxSAT) instance which may be violated at cost @c weight. WCNF line "WEIGHT literals... 0" with
+ * weight below top weight of header, lines with top weight are hard clauses.
+ */
+struct SoftClause
+{
+    std::vector<int> literals;
+    unsigned long long weight;
+};
+
+/**
+ * Literal implied by cardinality or XOR constraint. Reason clause is generated from @c reason only when conflict
+ * analysis reaches the literal.
+ */
+struct ConstraintImplication
+{
+    int literal;
+    unsigned reason;    // propagator specific
+    bool unconditional; // implied by constraint alone, reason clause would be unit
+};
+
+#endif //FREAKSATSOLVER_EXTENDEDCONSTRAINTS_HXX
@@ -2,302 +2,731 @@
 #include <stack>
 #include <queue>
 #include <algorithm>
+#include <random>
+#include <limits>
+#include <chrono>
+#include <iostream>
+#include <iterator>
 #include "GraspTwlImplementation.hxx"
 #include "Solver.hxx"
 #include "ChaffTwoWatchedLiterals.hxx"
+#include "ResultCache.hxx"
+#include "BinaryCnf.hxx"
+#include "CheckpointFormatException.hxx"
 
 using namespace std;
 
-GraspTwlImplementation::GraspTwlImplementation(Solver &satInstance) : satInstance(satInstance),
-                                                                      model(satInstance.nbVariables + 1,
-                                                                            Variable::UNKNOWN),
-                                                                      delta(satInstance.nbVariables + 1, -1),
-                                                                      vsidsCounter(satInstance.nbVariables + 1),
-                                                                      implicationGraph(satInstance.nbVariables + 2),
-                                                                      conflictVertexIdx(satInstance.nbVariables + 1)
-{}
+constexpr unsigned focusedRestartUnit = 22;
+constexpr unsigned long long rephaseInterval = 700;
+constexpr size_t checkpointClauseSizeLimit = 12; // longer learned clauses are rarely useful after resume
 
+/**
+ * i-th element (counted from 1) of Luby sequence 1 1 2 1 1 2 4 ...
+ */
+static unsigned luby(unsigned i)
+{
+    for (unsigned size = 1;; size = 2 * size + 1) {
+        if (size == i) {
+            return (size + 1) / 2;
+        }
+        if (size > i) {
+            return luby(i - size / 2);
+        }
+    }
+}
 
-SolverResult GraspTwlImplementation::trySolve()
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::GraspTwlImplementation(Solver &satInstance)
+        : satInstance(satInstance),
+          values(2 * satInstance.nbVariables + 3, Variable::UNKNOWN),
+          value(values.data() + satInstance.nbVariables + 1),
+          delta(satInstance.nbVariables + 1, -1),
+          vsidsCounter(satInstance.nbVariables + 1),
+          phases(satInstance.nbVariables + 1, Variable::POSITIVE),
+          targetPhases(satInstance.nbVariables + 1, Variable::UNKNOWN),
+          bestPhases(satInstance.nbVariables + 1, Variable::UNKNOWN),
+          engine(random_device()()),
+          reason(satInstance.nbVariables + 1, noReason),
+          implicationGraph(satInstance.nbVariables + 2),
+          impliedByUnitClause(satInstance.nbVariables + 2),
+          conflictVertexIdx(satInstance.nbVariables + 1),
+          budget(satInstance.options.limits, satInstance.options.cancellation),
+          proof(satInstance.options),
+          twl(*this),
+          cardinalities(satInstance.cardinalityConstraints, satInstance.nbVariables, value),
+          xors(satInstance.xorConstraints, satInstance.nbVariables, value, delta),
+          constraintReason(satInstance.nbVariables + 1),
+          assignedAt(satInstance.nbVariables + 1)
+{
+    formula.reserve(satInstance.nbClauses);
+    auto &snapshot = satInstance.snapshot;
+    for (unsigned i = 0; i < satInstance.nbClauses; ++i) {
+        if (snapshot) {
+            // mapped clause is checked while it is in cache anyway
+            satInstance.checkSnapshotClause(snapshot->clauseBegin(i), snapshot->clauseEnd(i));
+            formula.emplace_back(snapshot->clauseBegin(i), snapshot->clauseEnd(i));
+        } else {
+            formula.emplace_back(satInstance.formula[i].begin(), satInstance.formula[i].end());
+        }
+    }
+    twl.reset();
+    findShortClauses();
+
+    queuePrev.resize(satInstance.nbVariables + 1);
+    queueNext.resize(satInstance.nbVariables + 1);
+    queueStamp.resize(satInstance.nbVariables + 1);
+    for (Literal i = 1; i <= satInstance.nbVariables; ++i) {
+        enqueue(i);
+    }
+    auto &options = satInstance.options;
+    stable = options.searchMode == SearchMode::STABLE;
+    modeLimit = options.searchMode == SearchMode::ALTERNATE ? modeLength : numeric_limits<unsigned long long>::max();
+    rephaseLimit = options.rephase ? rephaseInterval : numeric_limits<unsigned long long>::max();
+    if (!options.checkpointPath.empty()) {
+        formulaKey = ResultCache::formulaKey(satInstance);
+        resumeFromCheckpoint();
+        checkpointWriter.reset(new CheckpointWriter(options.checkpointPath));
+        nextCheckpoint = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(
+                chrono::duration<double>(options.checkpointInterval));
+    }
+}
+
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+SolverResult GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::trySolve()
 {
     unsigned beta;
-    for (restartTakesPlace = false;; restartTakesPlace = false, restartFactor += restartFactor / 2) {
+    suspended = false;
+    failedAssumptions.clear();
+    if (xors.isInconsistent()) {
+        return SolverResult::UNSAT;
+    }
+    for (restartTakesPlace = false;; restartTakesPlace = false) {
         conflictCounter = 0;
-        for (int i = 1; i <= satInstance.nbVariables; ++i) {
-            model[i] = Variable::UNKNOWN;
-            vsidsCounter[i] = 0;
+        restartLimit = stable ? restartFactor : focusedRestartUnit * luby(++focusedRestarts);
+        for (Literal i = 1; i <= satInstance.nbVariables; ++i) {
+            purgeLiteral(i);
+            vsidsCounter[i] /= 2; // decay, recent conflicts weigh more
         }
+        queueSearch = queueLast;
+        nextAssumption = 0;
         trail.clear();
+        xors.releaseReasons(0);
+        savedTrail.clear();
+        keptAssignments.clear();
+        removeConflictVertex(0); // analysis cached before restart refers to assignment which no longer exists
         if (search(0, beta) != SUCCESS) {
+            if (emptyClauseLearned) {
+                proof.addClause(ClauseRepresentation());
+                return SolverResult::UNSAT;
+            }
+            if (!failedAssumptions.empty()) {
+                return SolverResult::UNSAT; // under assumptions only, next call may change them
+            }
+            if (budgetExhausted) {
+                if (checkpointWriter) {
+                    saveCheckpoint();
+                    checkpointWriter->flush();
+                }
+                return SolverResult::UNKNOWN;
+            }
             if (restartTakesPlace) {
+                statistics.restart();
+                if (restartHook && restartHook(phases)) {
+                    return SolverResult::SAT;
+                }
+                if (stable) {
+                    restartFactor += restartFactor / 2;
+                }
+                updateSearchMode();
+                if (checkpointWriter && chrono::steady_clock::now() >= nextCheckpoint) {
+                    saveCheckpoint();
+                }
+                if (conflicts >= sliceLimit) {
+                    // assignment is gone, everything else stays for next call
+                    suspended = true;
+                    return SolverResult::UNKNOWN;
+                }
                 continue;
             }
+            proof.addClause(ClauseRepresentation());
             return SolverResult::UNSAT;
         } else {
-            assert(isModelOfSatInstance());
+            assert(!Checks::enabled || isModelOfSatInstance());
             return SolverResult::SAT;
         }
     }
 }
 
-GraspTwlImplementation::ImplementationResult GraspTwlImplementation::search(unsigned d, unsigned &beta)
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+auto GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::search(unsigned d, unsigned &beta) -> ImplementationResult
 {
     assert(trail.size() == d);
     assert(d <= satInstance.nbVariables);
-    if (restartTakesPlace) {
+    if (searchInterrupted()) {
         return CONFLICT;
     }
     switch (decide(d)) {
         case VsidsResult::SUCCESS:
             return SUCCESS;
         case VsidsResult::FAILED:
-            beta = d - 1;
-            return CONFLICT;
+            return CONFLICT; // search unwinds like on restart
         case VsidsResult::CONFLICT:
             assert(trail.size() == d + 1);
-            for (int iteration = 0;; iteration++) {
-                if (restartTakesPlace) {
+            for (;;) {
+                if (searchInterrupted()) {
                     return CONFLICT;
                 }
-                bool deducedConflict = true;
                 if (deduce(d) != CONFLICT) {
                     if (search(d + 1, beta) == SUCCESS) {
                         trail.pop_back();
                         return SUCCESS;
-                    } else if (beta != d) {
-                        erase();
-                        trail.pop_back();
-                        return CONFLICT;
                     }
-                    deducedConflict = false;
-                };
-                if (diagnose(d, beta) == CONFLICT) {
-                    erase();
+                } else if (diagnose(d, beta) == CONFLICT) {
+                    erase(false);
+                    trail.pop_back();
+                    return CONFLICT;
+                }
+                if (restartTakesPlace || beta != d) {
+                    // beta is meaningless when search is unwinding
+                    erase(!restartTakesPlace);
                     trail.pop_back();
                     return CONFLICT;
                 }
-                erase();
+                // level is rebuilt from assignments of lower levels which were on erased ones, learned clause is
+                // asserted by deduce
+                erase(true);
+                trail.back().truthAssignment.swap(keptAssignments);
             }
     }
     assert(false);
     __builtin_unreachable();
 }
 
-GraspTwlImplementation::VsidsResult GraspTwlImplementation::decide(unsigned d)
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+auto GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::decide(unsigned d) -> VsidsResult
 {
-    if (isModelOfSatInstance()) {
-        return VsidsResult::SUCCESS;
+    // backjump may undo assumption while levels above it stay, so first one not holding is decided, not d-th one
+    while (nextAssumption < assumptions.size() && literalValue(assumptions[nextAssumption]) == Variable::POSITIVE) {
+        ++nextAssumption;
+    }
+    Literal decision;
+    if (nextAssumption < assumptions.size()) {
+        decision = assumptions[nextAssumption];
+        if (literalValue(decision) == Variable::NEGATIVE) {
+            analyzeFailedAssumption(decision);
+            restartTakesPlace = true;
+            return VsidsResult::FAILED;
+        }
+    } else {
+        Literal variable = stable ? nextVsidsVariable() : nextQueueVariable();
+        if (variable == 0) {
+            // Propagation is complete, so full assignment without conflict satisfies every clause
+            assert(!Checks::enabled || isModelOfSatInstance());
+            return VsidsResult::SUCCESS;
+        }
+        auto phase = stable && targetPhases[variable] != Variable::UNKNOWN ? targetPhases[variable] : phases[variable];
+        decision = phase == Variable::NEGATIVE ? -variable : variable;
     }
-    // VSIDS here
-    vector<Literal> candidates;
-    unsigned maxValue = 0;
     trail.emplace_back();
     assert(trail.size() == d + 1);
-    assert(model.size() == satInstance.nbVariables + 1);
-    for (Literal i = 1; i < model.size(); ++i) {
-        assert(i <= satInstance.nbVariables);
-        if (model[i] == Variable::UNKNOWN) {
-            maxValue = max(maxValue, vsidsCounter[i]);
+    trail.back().xorReasons = xors.reasonCount();
+    Literal l = abs(decision);
+
+    setLiteral(decision);
+    delta[l] = d;
+    trail.back().truthAssignment.push_back(decision);
+    implicationGraph[l].clear();
+    impliedByUnitClause[l] = false;
+    reason[l] = noReason;
+    statistics.decision();
+    return VsidsResult::CONFLICT; // not SUCCESS
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+auto GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::deduce(unsigned d) -> ImplementationResult
+{
+    auto &assignment = trail.back().truthAssignment;
+    // Unit clauses and clause learned from last conflict are not triggered by watches
+    for (auto clauseIdx : shortClauses) {
+        if (propagateIfUnit(clauseIdx, d) == CONFLICT) {
+            return CONFLICT;
         }
     }
-    for (Literal i = 1; i < model.size(); ++i) {
-        assert(i <= satInstance.nbVariables);
-        if ((model[i] == Variable::UNKNOWN) && (vsidsCounter[i] == maxValue)) {
-            candidates.push_back(i);
+    if (lastLearnedClause != noReason && propagateIfUnit(lastLearnedClause, d) == CONFLICT) {
+        return CONFLICT;
+    }
+    if (propagateConstraintUnits(d) == CONFLICT) {
+        return CONFLICT;
+    }
+    if (replaySavedTrail(d) == CONFLICT) {
+        return CONFLICT;
+    }
+    // assignment of this level is the propagation queue, assignments kept by backtracking are propagated again as
+    // watches of their clauses may have moved to literals unassigned by it
+    for (size_t next = 0; next < assignment.size(); ++next) {
+        auto conflict = twl.literalIsGoingToNegative(-assignment[next], [this, d](Literal h, unsigned clauseIdx) {
+            imply(h, clauseIdx, d);
+        });
+        if (conflict != twl.noConflict) {
+            recordConflict(conflict);
+            return CONFLICT;
+        }
+        if (propagateConstraints(assignment[next], d) == CONFLICT) {
+            return CONFLICT;
         }
     }
-    static mt19937 engine(time(0));
-    if (!candidates.empty()) {
-        uniform_int_distribution<unsigned> choose(0, candidates.size() - 1);
-        Literal l = candidates[choose(engine)];
+    return SUCCESS;
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+auto GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::propagateConstraints(Literal l, unsigned d)
+-> ImplementationResult
+{
+    if (!cardinalities.empty() &&
+        implyByConstraints(cardinalityReason, cardinalities.propagate(l, implied), d) == CONFLICT) {
+        return CONFLICT;
+    }
+    if (!xors.empty() && implyByConstraints(xorReason, xors.propagate(abs(l), implied), d) == CONFLICT) {
+        return CONFLICT;
+    }
+    return SUCCESS;
+}
 
-        model[l] = Variable::POSITIVE;
-        delta[l] = d;
-        trail.back().truthAssignment.push_back(l);
-        implicationGraph[l].clear();
-        return VsidsResult::CONFLICT; // not SUCCESS
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+auto GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::propagateConstraintUnits(unsigned d)
+-> ImplementationResult
+{
+    if (!cardinalities.empty() &&
+        implyByConstraints(cardinalityReason, cardinalities.propagateUnits(implied), d) == CONFLICT) {
+        return CONFLICT;
+    }
+    if (!xors.empty() && implyByConstraints(xorReason, xors.propagateUnits(implied), d) == CONFLICT) {
+        return CONFLICT;
     }
-    trail.pop_back();
-    return VsidsResult::FAILED;
+    return SUCCESS;
 }
 
-GraspTwlImplementation::ImplementationResult GraspTwlImplementation::deduce(unsigned d)
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+auto GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::implyByConstraints(unsigned kind, unsigned conflict,
+                                                                                unsigned d) -> ImplementationResult
 {
-    assert(trail.back().truthAssignment.size() <= 1);
-    queue<Literal> Q;
-    for (auto &clause : satInstance.formula) {
-        if (Literal l = isUnit(clause)) {
-            unsigned clauseIdx = &clause - satInstance.formula.data();
-            assert(&satInstance.formula[clauseIdx] == &clause);
-            if (literalValue(l) != Variable::UNKNOWN) {
-                // failed
-                recordConflict(clauseIdx);
-                return CONFLICT;
+    static_assert(CardinalityPropagator::noConflict == XorPropagator::noConflict, "single conflict marker");
+    if (conflict == XorPropagator::noConflict) {
+        for (auto &implication : implied) {
+            Literal l = implication.literal;
+            auto v = literalValue(l);
+            if (v == Variable::NEGATIVE) {
+                // literal is implied by constraint which became violated in the meantime
+                conflict = implication.reason;
+                break;
+            }
+            if (v == Variable::UNKNOWN) {
+                Literal variable = abs(l);
+                trail.back().truthAssignment.push_back(l);
+                implicationGraph[variable].clear(); // filled by expandReason if analysis needs it
+                impliedByUnitClause[variable] = implication.unconditional;
+                reason[variable] = kind;
+                constraintReason[variable] = implication.reason;
+                delta[variable] = d;
+                setLiteral(l);
+                statistics.propagation();
             }
-            recordVariable(l, clauseIdx);
-            delta[abs(l)] = d;
-            setLiteral(l);
         }
     }
-    ChaffTwoWatchedLiterals twl(satInstance, *this);
-    while (!Q.empty()) {
-        Literal l = Q.front();
-        Q.pop();
-        auto range = twl.watchedOccurrences(-l);
-        for (auto clause = range.first; clause != range.second; ++clause) {
-            // We were watching -l in clause, but -l has been made false
-            Literal h = twl.literalIsGoingToNegative(clause);
-            if (h) {
-                Variable v = literalValue(h);
-                if (v == Variable::NEGATIVE) {
-                    // C is effectively an empty clause
-                    // failed
-                    recordConflict(clause->second.clauseIdx);
-                    return CONFLICT;
-                } else {
-                    // C is effectively unit
-                    if (v != Variable::POSITIVE) {
-                        assert(v == Variable::UNKNOWN);
-                        recordVariable(h, clause->second.clauseIdx);
-                        delta[abs(h)] = d;
-                        setLiteral(h);
-                        Q.push(h);
-                    }
-                }
+    implied.clear();
+    if (conflict != XorPropagator::noConflict) {
+        recordConstraintConflict(kind, conflict);
+        return CONFLICT;
+    }
+    return SUCCESS;
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::recordConstraintConflict(unsigned kind, unsigned conflict)
+{
+    explanation.clear();
+    if (kind == cardinalityReason) {
+        cardinalities.conflictVariables(conflict, explanation);
+    } else {
+        xors.reasonVariables(conflict, 0, explanation);
+    }
+    implicationGraph[conflictVertexIdx].assign(explanation.begin(), explanation.end());
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::analyzeFailedAssumption(Literal assumption)
+{
+    // other decisions are taken only while all assumptions hold, so every decision so far is an assumption
+    failedAssumptions.assign(1, assumption);
+    vector<bool> visited(satInstance.nbVariables + 1);
+    vector<Literal> stack(1, abs(assumption));
+    visited[abs(assumption)] = true;
+    while (!stack.empty()) {
+        Literal variable = stack.back();
+        stack.pop_back();
+        if (reason[variable] == noReason) {
+            failedAssumptions.push_back(value[variable] == Variable::POSITIVE ? variable : -variable);
+            continue;
+        }
+        if (reason[variable] == cardinalityReason || reason[variable] == xorReason) {
+            expandReason(variable);
+        }
+        for (auto antecedent : implicationGraph[variable]) {
+            if (!visited[antecedent]) {
+                visited[antecedent] = true;
+                stack.push_back(antecedent);
             }
         }
     }
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::expandReason(Literal variable)
+{
+    explanation.clear();
+    if (reason[variable] == cardinalityReason) {
+        auto time = assignedAt[variable];
+        cardinalities.reasonVariables(constraintReason[variable], [this, time](int l) {
+            return assignedAt[abs(l)] < time;
+        }, explanation);
+    } else {
+        assert(reason[variable] == xorReason);
+        xors.reasonVariables(constraintReason[variable], variable, explanation);
+    }
+    implicationGraph[variable].assign(explanation.begin(), explanation.end());
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+auto GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::propagateIfUnit(unsigned clauseIdx, unsigned d)
+-> ImplementationResult
+{
+    auto &clause = formula[clauseIdx];
+    if (clause.empty()) {
+        recordConflict(clauseIdx);
+        return CONFLICT;
+    }
+    if (Literal l = isUnit(clause)) {
+        if (literalValue(l) != Variable::UNKNOWN) {
+            // failed
+            recordConflict(clauseIdx);
+            return CONFLICT;
+        }
+        imply(l, clauseIdx, d);
+    }
     return SUCCESS;
 }
 
-GraspTwlImplementation::ImplementationResult GraspTwlImplementation::diagnose(unsigned d, unsigned &beta)
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::imply(Literal l, unsigned clauseIdx, unsigned d)
+{
+    recordVariable(l, clauseIdx);
+    Literal variable = abs(l);
+    int level = 0;
+    for (auto antecedent : implicationGraph[variable]) {
+        level = max(level, delta[antecedent]);
+    }
+    assert(level <= static_cast<int>(d));
+    delta[variable] = level;
+    setLiteral(l);
+    statistics.propagation();
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+auto GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::diagnose(unsigned d, unsigned &beta)
+-> ImplementationResult
 {
     conflictCounter += 1;
-    if (conflictCounter >= restartFactor) {
+    conflicts += 1;
+    statistics.conflict();
+    if (conflictCounter >= restartLimit || conflicts >= rephaseLimit || conflicts >= modeLimit ||
+        conflicts >= sliceLimit) {
         restartTakesPlace = true;
     }
-    const auto &newClause = getConflictInducedClause(d);
+    if (checkpointWriter && chrono::steady_clock::now() >= nextCheckpoint) {
+        // checkpoint is taken at restart, stable mode without rephasing restarts ever more rarely
+        restartTakesPlace = true;
+    }
+    updateTargetPhases(d);
+    int conflictLevel = -1; // lower than d if conflicting literals were assigned out of order
+    for (auto variable : implicationGraph[conflictVertexIdx]) {
+        conflictLevel = max(conflictLevel, delta[variable]);
+    }
+    const auto &newClause = getConflictInducedClause(conflictLevel);
+    if (newClause.empty()) {
+        // conflict does not depend on any decision
+        emptyClauseLearned = true;
+        restartTakesPlace = true;
+        return CONFLICT;
+    }
     updateClauseDatabase(newClause, d);
-    beta = 0;
+    int assertionLevel = -1;
     for (auto l : newClause) {
         assert(delta[abs(l)] >= 0);
-        beta = max<unsigned>(beta, delta[abs(l)]);
+        if (delta[abs(l)] != conflictLevel) {
+            assertionLevel = max(assertionLevel, delta[abs(l)]);
+        }
     }
-    if (beta != d) {
-        return CONFLICT;
+    auto chronoThreshold = satInstance.options.chronoThreshold;
+    if (chronoThreshold > 0 && conflictLevel - assertionLevel > static_cast<int>(chronoThreshold)) {
+        backtrackLevel = conflictLevel - 1;
+    } else {
+        backtrackLevel = assertionLevel;
     }
+    beta = backtrackLevel + 1;
     removeConflictVertex(d);
     return SUCCESS;
 }
 
-void GraspTwlImplementation::erase()
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::erase(bool save)
 {
     // implication graph lazy
-    for (auto l : trail.back().truthAssignment) {
-        purgeLiteral(l);
+    auto &assignment = trail.back().truthAssignment;
+    int keptLevel = restartTakesPlace ? -1 : backtrackLevel;
+    nextAssumption = 0;
+    save = save && satInstance.options.trailSaving;
+    for (auto l = assignment.rbegin(); l != assignment.rend(); ++l) {
+        Literal variable = abs(*l);
+        if (delta[variable] <= keptLevel) {
+            // implied out of order by clause, literals implied by constraints are assigned at level of search
+            keptAssignments.push_back(*l);
+            continue;
+        }
+        if (save) {
+            savedTrail.push_back({*l, reason[variable]});
+        }
+        phases[variable] = *l > 0 ? Variable::POSITIVE : Variable::NEGATIVE;
+        if (queueStamp[variable] > queueStamp[queueSearch]) {
+            queueSearch = variable;
+        }
+        purgeLiteral(*l);
+    }
+    assignment.clear();
+    xors.releaseReasons(trail.back().xorReasons);
+    if (savedTrail.size() > 2 * static_cast<size_t>(satInstance.nbVariables)) {
+        // bottom of stack was undone by earlier backtracks, its reasons are least likely to be unit again
+        savedTrail.erase(savedTrail.begin(), savedTrail.end() - satInstance.nbVariables);
     }
-    trail.back().truthAssignment.clear();
 }
 
-void GraspTwlImplementation::recordConflict(unsigned clauseIdx)
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+auto GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::replaySavedTrail(unsigned d) -> ImplementationResult
+{
+    for (; !savedTrail.empty(); savedTrail.pop_back()) {
+        auto saved = savedTrail.back();
+        auto v = literalValue(saved.literal);
+        if (saved.reason == noReason) {
+            if (v == Variable::UNKNOWN) {
+                return SUCCESS; // assignments saved after this decision depend on it
+            }
+            continue;
+        }
+        if (v == Variable::POSITIVE || saved.reason >= formula.size() ||
+            !isReasonOf(saved.reason, saved.literal)) {
+            continue;
+        }
+        if (v == Variable::NEGATIVE) {
+            recordConflict(saved.reason);
+            savedTrail.pop_back();
+            return CONFLICT;
+        }
+        imply(saved.literal, saved.reason, d);
+    }
+    return SUCCESS;
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+bool GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::isReasonOf(unsigned clauseIdx, Literal l) const
+{
+    bool containsLiteral = false;
+    for (auto ll : formula[clauseIdx]) {
+        if (ll == l) {
+            containsLiteral = true;
+        } else if (literalValue(ll) != Variable::NEGATIVE) {
+            return false;
+        }
+    }
+    return containsLiteral;
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::recordConflict(unsigned clauseIdx)
 {
     implicationGraph[conflictVertexIdx].clear();
-    for (auto l : satInstance.formula[clauseIdx]) {
+    for (auto l : formula[clauseIdx]) {
         implicationGraph[conflictVertexIdx].push_back(abs(l));
     }
 }
 
-void GraspTwlImplementation::recordVariable(Literal l, unsigned clauseIdx)
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::recordVariable(Literal l, unsigned clauseIdx)
 {
     trail.back().truthAssignment.push_back(l);
     auto variable = abs(l);
     assert(variable != conflictVertexIdx);
     implicationGraph[variable].clear();
     assert(literalValue(l) == Variable::UNKNOWN);
-    for (auto ll : satInstance.formula[clauseIdx]) {
+    for (auto ll : formula[clauseIdx]) {
         if (ll == l) {
             continue;
         }
         assert(literalValue(ll) != Variable::UNKNOWN);
         implicationGraph[variable].push_back(abs(ll));
     }
+    impliedByUnitClause[variable] = implicationGraph[variable].empty();
+    reason[variable] = clauseIdx;
 }
 
-const GraspTwlImplementation::ClauseRepresentation &GraspTwlImplementation::getConflictInducedClause(unsigned d)
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+auto GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::getConflictInducedClause(int &conflictLevel)
+-> const ClauseRepresentation &
 {
-    if (clauseFromConflict.empty()) {
-        vector<bool> V(satInstance.nbVariables + 2);
-        firstUip(conflictVertexIdx, V);
+    clauseFromConflict.clear();
+    vector<bool> V(satInstance.nbVariables + 2);
+    for (;;) {
+        firstUip(conflictVertexIdx, conflictLevel, V);
+        int highest = -1;
+        for (auto l : clauseFromConflict) {
+            highest = max(highest, delta[abs(l)]);
+        }
+        if (highest == conflictLevel || highest < 0) {
+            break;
+        }
+        // literals of conflict level (implied by constraints at level of search) depend on lower levels only
+        implicationGraph[conflictVertexIdx].clear();
+        for (auto l : clauseFromConflict) {
+            implicationGraph[conflictVertexIdx].push_back(abs(l));
+        }
+        clauseFromConflict.clear();
+        fill(V.begin(), V.end(), false);
+        conflictLevel = highest;
+    }
+    if (Checks::enabled) {
         int decisionCount = 0;
         for (auto l : clauseFromConflict) {
-            if (delta[abs(l)] == d) {
+            if (delta[abs(l)] == conflictLevel) {
                 decisionCount += 1;
             }
-            assert(model[abs(l)] != Variable::UNKNOWN);
+            assert(literalValue(l) == Variable::NEGATIVE);
         }
         assert(decisionCount <= 1);
-        if (clauseFromConflict.size() > 0) {
-            clauseGeneration += 1;
-        }
+    }
+    if (clauseFromConflict.size() > 0) {
+        clauseGeneration += 1;
     }
     return clauseFromConflict;
 }
 
-void GraspTwlImplementation::updateClauseDatabase(const ClauseRepresentation &newClause, unsigned d)
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::updateClauseDatabase(const ClauseRepresentation &newClause,
+                                                                                  unsigned d)
 {
     if (clauseGeneration != databaseVersion) {
         databaseVersion = clauseGeneration;
-        satInstance.formula.push_back(newClause);
         maybeGarbargeCollect();
+        lastLearnedClause = formula.size();
+        formula.push_back(newClause);
+        auto &clause = formula.back();
+        // watch two literals assigned last, they are first to be unassigned by backtracking
+        for (size_t i = 0; i < min<size_t>(2, clause.size()); ++i) {
+            for (size_t j = i + 1; j < clause.size(); ++j) {
+                if (delta[abs(clause[j])] > delta[abs(clause[i])]) {
+                    swap(clause[i], clause[j]);
+                }
+            }
+        }
+        if (clause.size() >= 2) {
+            twl.watchClause(lastLearnedClause);
+        } else {
+            shortClauses.push_back(lastLearnedClause);
+        }
+        proof.addClause(newClause);
+        statistics.learnedClause();
         for (auto l : newClause) {
             vsidsCounter[abs(l)] += 1;
         }
+        bumpQueue(newClause);
+    }
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::findShortClauses()
+{
+    shortClauses.clear();
+    for (unsigned clauseIdx = 0; clauseIdx < formula.size(); ++clauseIdx) {
+        if (formula[clauseIdx].size() < 2) {
+            shortClauses.push_back(clauseIdx);
+        }
     }
 }
 
-void GraspTwlImplementation::removeConflictVertex(unsigned d)
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::removeConflictVertex(unsigned d)
 {
     // done (lazy)
     clauseFromConflict.clear();
     implicationGraph[conflictVertexIdx].clear();
 }
 
-void GraspTwlImplementation::firstUip(Literal l, vector<bool> &V)
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::firstUip(Literal l, int conflictLevel, vector<bool> &V)
 {
     assert(l > 0);
     if (V[l]) {
         return;
     }
     V[l] = true;
-    if (((l == conflictVertexIdx) || (delta[l] == trail.size() - 1)) && (implicationGraph[l].size() > 0)) {
+    if (l != conflictVertexIdx && delta[l] == conflictLevel &&
+        (reason[l] == cardinalityReason || reason[l] == xorReason)) {
+        expandReason(l);
+    }
+    if (((l == conflictVertexIdx) || (delta[l] == conflictLevel)) && (implicationGraph[l].size() > 0)) {
         assert((l == conflictVertexIdx) || (literalValue(l) != Variable::UNKNOWN));
         for (auto n : implicationGraph[l]) {
-            firstUip(n, V);
+            firstUip(n, conflictLevel, V);
         }
-    } else if (l != conflictVertexIdx) {
+    } else if (l != conflictVertexIdx && !impliedByUnitClause[l]) {
         auto v = literalValue(l);
         assert(v != Variable::UNKNOWN);
         clauseFromConflict.push_back(v == Variable::POSITIVE ? -l : l);
     }
 }
 
-void GraspTwlImplementation::maybeGarbargeCollect()
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::maybeGarbargeCollect()
 {
     constexpr size_t clauseSizeLimit = 25;
     constexpr size_t databaseSizeLimit = 1000000;
-    if (satInstance.formula.size() <= databaseSizeLimit) {
+    if (formula.size() <= databaseSizeLimit) {
         return;
     }
     size_t i = satInstance.nbClauses, j = satInstance.nbClauses;
-    for (; j < satInstance.formula.size(); ++j) {
-        if (satInstance.formula[j].size() <= clauseSizeLimit) {
-            satInstance.formula[i++] = move(satInstance.formula[j]);
+    for (; j < formula.size(); ++j) {
+        bool added = j < addedClauses.size() && addedClauses[j];
+        if (added || formula[j].size() <= clauseSizeLimit) {
+            if (i != j) {
+                formula[i] = move(formula[j]); // self-move would empty the clause
+            }
+            if (i < addedClauses.size()) {
+                addedClauses[i] = added;
+            }
+            ++i;
+        } else {
+            proof.deleteClause(formula[j]);
         }
     }
-    satInstance.formula.erase(satInstance.formula.begin() + i, satInstance.formula.end());
+    formula.erase(formula.begin() + i, formula.end());
+    addedClauses.resize(min(addedClauses.size(), i));
+    savedTrail.clear(); // reasons are clause indices
+    lastLearnedClause = noReason;
+    twl.reset();
+    findShortClauses();
 }
 
-bool GraspTwlImplementation::solveSat(std::unordered_set<Literal> &variablesToBeAssigned)
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+bool GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::solveSat(
+        std::unordered_set<Literal> &variablesToBeAssigned)
 {
     if (variablesToBeAssigned.empty()) {
         return isModelOfSatInstance();
@@ -307,7 +736,7 @@ bool GraspTwlImplementation::solveSat(std::unordered_set<Literal> &variablesToBe
     vector<Literal> upResult = propagateLiteral(choosenVariable);
     if (!upResult.empty()) {
         for (Literal l : upResult) {
-            assert(model[abs(l)] == (l > 0 ? Variable::POSITIVE : Variable::NEGATIVE));
+            assert(literalValue(l) == Variable::POSITIVE);
             variablesToBeAssigned.erase(abs(l));
         }
         if (solveSat(variablesToBeAssigned)) {
@@ -315,8 +744,8 @@ bool GraspTwlImplementation::solveSat(std::unordered_set<Literal> &variablesToBe
         }
         // rollback, memento in future
         for (Literal l : upResult) {
-            assert(model[abs(l)] != Variable::UNKNOWN);
-            model[abs(l)] = Variable::UNKNOWN;
+            assert(literalValue(l) != Variable::UNKNOWN);
+            purgeLiteral(l);
             variablesToBeAssigned.insert(abs(l));
         }
     }
@@ -325,7 +754,7 @@ bool GraspTwlImplementation::solveSat(std::unordered_set<Literal> &variablesToBe
         return false;
     }
     for (Literal l : upResult) {
-        assert(model[abs(l)] == (l > 0 ? Variable::POSITIVE : Variable::NEGATIVE));
+        assert(literalValue(l) == Variable::POSITIVE);
         variablesToBeAssigned.erase(abs(l));
     }
     if (solveSat(variablesToBeAssigned)) {
@@ -333,21 +762,21 @@ bool GraspTwlImplementation::solveSat(std::unordered_set<Literal> &variablesToBe
     } else {
         // rollback, memento in future
         for (Literal l : upResult) {
-            assert(model[abs(l)] != Variable::UNKNOWN);
-            model[abs(l)] = Variable::UNKNOWN;
+            assert(literalValue(l) != Variable::UNKNOWN);
+            purgeLiteral(l);
             variablesToBeAssigned.insert(abs(l));
         }
         return false;
     }
 }
 
-vector<GraspTwlImplementation::Literal> GraspTwlImplementation::propagateLiteral(Literal literal)
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+auto GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::propagateLiteral(Literal literal) -> vector<Literal>
 {
-    queue<Literal> Q;
     vector<Literal> result;
     result.push_back(literal);
     setLiteral(literal);
-    for (auto clause : satInstance.formula) {
+    for (auto &clause : formula) {
         if (Literal l = isUnit(clause)) {
             if (literalValue(l) != Variable::UNKNOWN) {
                 // failed - rollback
@@ -360,75 +789,417 @@ vector<GraspTwlImplementation::Literal> GraspTwlImplementation::propagateLiteral
             setLiteral(l);
         }
     }
-    ChaffTwoWatchedLiterals twl(satInstance, *this);
-    while (!Q.empty()) {
-        Literal l = Q.front();
-        Q.pop();
-        auto range = twl.watchedOccurrences(-l);
-        for (auto clause = range.first; clause != range.second; ++clause) {
-            // We were watching -l in clause, but -l has been made false
-            Literal h = twl.literalIsGoingToNegative(clause);
-            if (h) {
-                Variable v = literalValue(h);
-                if (v == Variable::NEGATIVE) {
-                    // C is effectively an empty clause
-                    // failed - rollback
-                    for (Literal ll : result) {
-                        purgeLiteral(ll);
-                    }
-                    return {};
-                } else {
-                    // C is effectively unit
-                    if (v != Variable::POSITIVE) {
-                        result.push_back(h);
-                        setLiteral(h);
-                        Q.push(h);
-                    }
+    return result;
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+const vector<Variable> GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::getModel() const
+{
+    return vector<Variable>(value, value + satInstance.nbVariables + 1);
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::setAssumptions(const std::vector<int> &assumptions)
+{
+    this->assumptions.assign(assumptions.begin(), assumptions.end());
+    nextAssumption = 0;
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+const vector<int> &GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::getFailedAssumptions() const
+{
+    return failedAssumptions;
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::addClause(const std::vector<int> &clause)
+{
+    // nothing is assigned at start of next trySolve, so any two literals may be watched
+    unsigned clauseIdx = formula.size();
+    formula.emplace_back(clause.begin(), clause.end());
+    addedClauses.resize(formula.size());
+    addedClauses[clauseIdx] = true;
+    if (clause.size() >= 2) {
+        twl.watchClause(clauseIdx);
+    } else {
+        shortClauses.push_back(clauseIdx);
+    }
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+vector<int> GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::getModelCube(const std::vector<bool> &projected)
+{
+    // values and implication graph of model stay in place until next trySolve
+    vector<int> cube;
+    vector<char> state(satInstance.nbVariables + 1, 0);
+    for (Literal variable = 1; variable <= satInstance.nbVariables; ++variable) {
+        if (projected[variable] && !isFixedByProjection(variable, projected, state)) {
+            cube.push_back(value[variable] == Variable::POSITIVE ? variable : -variable);
+        }
+    }
+    return cube;
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+bool GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::isFixedByProjection(Literal variable,
+                                                                                 const std::vector<bool> &projected,
+                                                                                 std::vector<char> &state)
+{
+    enum : char
+    {
+        UNVISITED, OPEN, FIXED, FREE,
+    };
+    // depth-first, implication graph of assignment is acyclic
+    vector<pair<Literal, size_t>> stack; // variable, next antecedent to check
+    if (state[variable] == UNVISITED) {
+        stack.emplace_back(variable, 0);
+    }
+    while (!stack.empty()) {
+        Literal current = stack.back().first;
+        size_t &next = stack.back().second;
+        if (state[current] == UNVISITED) {
+            if (reason[current] == noReason) {
+                state[current] = FREE;
+                stack.pop_back();
+                continue;
+            }
+            if (reason[current] == cardinalityReason || reason[current] == xorReason) {
+                expandReason(current);
+            }
+            state[current] = OPEN;
+        }
+        auto &antecedents = implicationGraph[current];
+        while (next < antecedents.size() && (projected[antecedents[next]] || state[antecedents[next]] == FIXED)) {
+            ++next;
+        }
+        if (next == antecedents.size()) {
+            state[current] = FIXED;
+            stack.pop_back();
+        } else if (state[antecedents[next]] == FREE) {
+            state[current] = FREE;
+            stack.pop_back();
+        } else {
+            assert(state[antecedents[next]] == UNVISITED);
+            stack.emplace_back(antecedents[next], 0);
+        }
+    }
+    return state[variable] == FIXED;
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+const Statistics &GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::getStatistics() const
+{
+    return statistics.get();
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::setPhases(const std::vector<Variable> &phases)
+{
+    assert(phases.size() == this->phases.size());
+    for (Literal i = 1; i <= satInstance.nbVariables; ++i) {
+        if (phases[i] != Variable::UNKNOWN) {
+            this->phases[i] = phases[i];
+        }
+    }
+    fill(targetPhases.begin(), targetPhases.end(), Variable::UNKNOWN);
+    targetAssigned = 0;
+    if (satInstance.options.rephase) {
+        rephaseLimit = max(rephaseLimit, conflicts + rephaseInterval);
+    }
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::setRestartHook(RestartHook hook)
+{
+    restartHook = move(hook);
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+const char *GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::getExhaustedResource() const
+{
+    return budget.getExhaustedResource();
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::setSliceLimit(unsigned long long conflicts)
+{
+    sliceLimit = conflicts == 0 ? numeric_limits<unsigned long long>::max() : this->conflicts + conflicts;
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+bool GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::isSuspended() const
+{
+    return suspended;
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+bool GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::searchInterrupted()
+{
+    if (!restartTakesPlace && budget.isExhausted(statistics.get())) {
+        budgetExhausted = true;
+        restartTakesPlace = true; // unwinds search just like restart does
+    }
+    return restartTakesPlace;
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::updateSearchMode()
+{
+    if (conflicts >= rephaseLimit) {
+        rephase();
+        rephaseLimit = conflicts + rephaseInterval * ++rephaseCount;
+    }
+    if (conflicts >= modeLimit) {
+        stable = !stable;
+        if (!stable) {
+            modeLength *= 2; // focused and stable mode get equal share of each round
+        }
+        modeLimit = conflicts + modeLength;
+        fill(targetPhases.begin(), targetPhases.end(), Variable::UNKNOWN);
+        targetAssigned = 0;
+    }
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::rephase()
+{
+    switch (rephaseCount % 6) {
+        case 0: // original
+            fill(phases.begin(), phases.end(), Variable::POSITIVE);
+            break;
+        case 1: // inverted
+            fill(phases.begin(), phases.end(), Variable::NEGATIVE);
+            break;
+        case 2:
+        case 4: // best
+            for (Literal i = 1; i <= satInstance.nbVariables; ++i) {
+                if (bestPhases[i] != Variable::UNKNOWN) {
+                    phases[i] = bestPhases[i];
                 }
             }
+            bestAssigned = 0;
+            break;
+        case 3:
+            walkPhases();
+            break;
+        default: {
+            assert(rephaseCount % 6 == 5);
+            uniform_int_distribution<int> coin(0, 1);
+            for (Literal i = 1; i <= satInstance.nbVariables; ++i) {
+                phases[i] = coin(engine) ? Variable::POSITIVE : Variable::NEGATIVE;
+            }
+            break;
         }
     }
-    return result;
+    fill(targetPhases.begin(), targetPhases.end(), Variable::UNKNOWN);
+    targetAssigned = 0;
 }
 
-const vector<Variable> GraspTwlImplementation::getModel() const
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::walkPhases()
 {
-    return model;
+    if (!walker) {
+        walker.reset(new ProbSatImplementation(satInstance));
+    }
+    walker->setPhases(phases);
+    // walk is part of this search, time and cancellation of search stop it
+    walker->trySolve(max<unsigned long long>(100000, 10ull * satInstance.nbClauses), budget, statistics.get());
+    auto &walked = walker->getBestModel();
+    if (walked.size() == phases.size()) {
+        setPhases(walked);
+    }
 }
 
-Variable GraspTwlImplementation::literalValue(Literal l) const
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::resumeFromCheckpoint()
 {
-    bool needNegation = l < 0;
-    if (needNegation) {
-        l = -l;
+    auto &options = satInstance.options;
+    Checkpoint checkpoint;
+    try {
+        if (!checkpoint.read(options.checkpointPath)) {
+            return;
+        }
+    } catch (const CheckpointFormatException &e) {
+        // damaged checkpoint is overwritten by the first new one
+        cerr << "c checkpoint >" << options.checkpointPath << "< is unusable (" << e.what()
+             << "), starting from scratch\n";
+        return;
     }
-    assert(abs(l) <= conflictVertexIdx);
-    if (l == conflictVertexIdx) {
-        return Variable::UNKNOWN;
+    auto &key = formulaKey;
+    if (checkpoint.nbVariables != satInstance.nbVariables ||
+        !equal(begin(key.hash), end(key.hash), begin(checkpoint.formulaHash))) {
+        cerr << "c checkpoint >" << options.checkpointPath << "< belongs to other formula, starting from scratch\n";
+        return;
     }
-    Variable result = model[l];
-    if (needNegation) {
-        if (result == Variable::NEGATIVE) {
-            result = Variable::POSITIVE;
-        } else if (result == Variable::POSITIVE) {
-            result = Variable::NEGATIVE;
+    for (auto l = checkpoint.clauses.begin(); l != checkpoint.clauses.end(); ++l) {
+        auto end = find(l, checkpoint.clauses.end(), 0);
+        formula.emplace_back(l, end);
+        l = end;
+    }
+    twl.reset();
+    findShortClauses();
+    copy(checkpoint.activities.begin(), checkpoint.activities.end(), vsidsCounter.begin());
+    copy(checkpoint.phases.begin(), checkpoint.phases.end(), phases.begin());
+    queueFirst = queueLast = 0;
+    for (auto v : checkpoint.queueOrder) {
+        enqueue(v);
+    }
+    queueSearch = queueLast;
+    statistics.restore(checkpoint.statistics);
+    conflicts = checkpoint.conflicts;
+    rephaseCount = checkpoint.rephaseCount;
+    if (options.rephase) {
+        rephaseLimit = conflicts + rephaseInterval * (rephaseCount + 1);
+    }
+    if (options.searchMode == SearchMode::ALTERNATE) {
+        stable = checkpoint.stable;
+        modeLength = checkpoint.modeLength;
+        modeLimit = conflicts + modeLength;
+    }
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::saveCheckpoint()
+{
+    Checkpoint checkpoint;
+    auto &key = formulaKey;
+    copy(begin(key.hash), end(key.hash), begin(checkpoint.formulaHash));
+    checkpoint.nbVariables = satInstance.nbVariables;
+    checkpoint.statistics = statistics.get();
+    checkpoint.conflicts = conflicts;
+    checkpoint.modeLength = modeLength;
+    checkpoint.rephaseCount = rephaseCount;
+    checkpoint.stable = stable;
+    checkpoint.activities = vsidsCounter;
+    checkpoint.phases = phases;
+    for (auto v = queueFirst; v != 0; v = queueNext[v]) {
+        checkpoint.queueOrder.push_back(v);
+    }
+    for (size_t clauseIdx = satInstance.nbClauses; clauseIdx < formula.size(); ++clauseIdx) {
+        auto &clause = formula[clauseIdx];
+        if (clause.size() <= checkpointClauseSizeLimit) {
+            checkpoint.clauses.insert(checkpoint.clauses.end(), clause.begin(), clause.end());
+            checkpoint.clauses.push_back(0);
         }
     }
-    return result;
+    checkpointWriter->submit(checkpoint.serialize());
+    nextCheckpoint = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(
+            chrono::duration<double>(satInstance.options.checkpointInterval));
 }
 
-GraspTwlImplementation::Literal GraspTwlImplementation::isUnit(ClauseRepresentation &clause)
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::updateTargetPhases(unsigned d)
+{
+    size_t assigned = 0;
+    for (unsigned level = 0; level < d; ++level) {
+        assigned += trail[level].truthAssignment.size();
+    }
+    bool target = stable && assigned > targetAssigned;
+    bool best = assigned > bestAssigned;
+    if (!target && !best) {
+        return;
+    }
+    for (unsigned level = 0; level < d; ++level) {
+        for (auto l : trail[level].truthAssignment) {
+            auto phase = l > 0 ? Variable::POSITIVE : Variable::NEGATIVE;
+            if (target) {
+                targetPhases[abs(l)] = phase;
+            }
+            if (best) {
+                bestPhases[abs(l)] = phase;
+            }
+        }
+    }
+    targetAssigned = target ? assigned : targetAssigned;
+    bestAssigned = best ? assigned : bestAssigned;
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+auto GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::nextQueueVariable() -> Literal
+{
+    while (queueSearch != 0 && value[queueSearch] != Variable::UNKNOWN) {
+        queueSearch = queuePrev[queueSearch];
+    }
+    return queueSearch;
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+auto GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::nextVsidsVariable() -> Literal
+{
+    vector<Literal> candidates;
+    unsigned maxValue = 0;
+    for (Literal i = 1; i <= satInstance.nbVariables; ++i) {
+        if (value[i] == Variable::UNKNOWN) {
+            maxValue = max(maxValue, vsidsCounter[i]);
+        }
+    }
+    for (Literal i = 1; i <= satInstance.nbVariables; ++i) {
+        if ((value[i] == Variable::UNKNOWN) && (vsidsCounter[i] == maxValue)) {
+            candidates.push_back(i);
+        }
+    }
+    if (candidates.empty()) {
+        return 0;
+    }
+    uniform_int_distribution<unsigned> choose(0, candidates.size() - 1);
+    return candidates[choose(engine)];
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::bumpQueue(const ClauseRepresentation &clause)
+{
+    vector<Literal> variables;
+    for (auto l : clause) {
+        variables.push_back(abs(l));
+    }
+    // keep relative order of bumped variables
+    sort(variables.begin(), variables.end(), [this](Literal a, Literal b) {
+        return queueStamp[a] < queueStamp[b];
+    });
+    for (auto variable : variables) {
+        dequeue(variable);
+        enqueue(variable);
+        if (value[variable] == Variable::UNKNOWN) {
+            queueSearch = variable;
+        }
+    }
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::enqueue(Literal variable)
+{
+    queuePrev[variable] = queueLast;
+    queueNext[variable] = 0;
+    if (queueLast != 0) {
+        queueNext[queueLast] = variable;
+    } else {
+        queueFirst = variable;
+    }
+    queueLast = variable;
+    queueStamp[variable] = ++queueTime;
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::dequeue(Literal variable)
+{
+    auto prev = queuePrev[variable], next = queueNext[variable];
+    (prev != 0 ? queueNext[prev] : queueFirst) = next;
+    (next != 0 ? queuePrev[next] : queueLast) = prev;
+}
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+auto GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::isUnit(ClauseRepresentation &clause) -> Literal
 {
     Literal result[2];
     unsigned resultsCount = 0;
     for (auto l : clause) {
-        auto value = literalValue(l);
-        if (value == Variable::POSITIVE) {
+        auto v = literalValue(l);
+        if (v == Variable::POSITIVE) {
             return 0;   // this clause does not exist - so it is not an unit clause
-        } else if (value == Variable::NEGATIVE) {
+        } else if (v == Variable::NEGATIVE) {
             // skip - this literal does not exist
         } else {
-            assert(value == Variable::UNKNOWN);
+            assert(v == Variable::UNKNOWN);
             result[resultsCount++] = l;
             if (resultsCount == 2) {
                 return 0; // this is not an unit clause
@@ -443,28 +1214,35 @@ GraspTwlImplementation::Literal GraspTwlImplementation::isUnit(ClauseRepresentat
     }
 }
 
-void GraspTwlImplementation::setLiteral(Literal l)
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::setLiteral(Literal l)
 {
-    if (l > 0) {
-        model[l] = Variable::POSITIVE;
-    } else {
-        assert(l < 0);
-        model[-l] = Variable::NEGATIVE;
+    assert(l != 0 && abs(l) != conflictVertexIdx);
+    value[l] = Variable::POSITIVE;
+    value[-l] = Variable::NEGATIVE;
+    if (!cardinalities.empty()) {
+        assignedAt[abs(l)] = ++assignmentTime;
+        cardinalities.assigned(l);
     }
 }
 
-void GraspTwlImplementation::purgeLiteral(Literal l)
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+void GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::purgeLiteral(Literal l)
 {
-    model[abs(l)] = Variable::UNKNOWN;
+    if (!cardinalities.empty() && value[l] != Variable::UNKNOWN) {
+        cardinalities.unassigned(value[l] == Variable::POSITIVE ? l : -l);
+    }
+    value[l] = Variable::UNKNOWN;
+    value[-l] = Variable::UNKNOWN;
 }
 
-bool GraspTwlImplementation::isModelOfSatInstance() const
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+bool GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::isModelOfSatInstance() const
 {
-    for (auto clause : satInstance.formula) {
+    for (auto &clause : formula) {
         bool clauseIsPositive = false;
         for (auto literal : clause) {
-            if ((literal < 0 && model[-literal] == Variable::NEGATIVE) ||
-                (literal > 0 && model[literal] == Variable::POSITIVE)) {
+            if (value[literal] == Variable::POSITIVE) {
                 clauseIsPositive = true;
                 break;
             }
@@ -473,22 +1251,21 @@ bool GraspTwlImplementation::isModelOfSatInstance() const
             return false;
         }
     }
-    return true;
+    return cardinalities.isSatisfied() && xors.isSatisfied();
 }
 
-SolverResult GraspTwlImplementation::canBeModelOfSatInstance() const
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+SolverResult GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::canBeModelOfSatInstance() const
 {
     bool formulaIsPositive = true;
-    for (auto clause : satInstance.formula) {
+    for (auto &clause : formula) {
         bool clauseIsPositive = false;
         bool clauseMayBePositive = false;
         for (auto literal : clause) {
-            if ((literal < 0 && model[-literal] == Variable::NEGATIVE) ||
-                (literal > 0 && model[literal] == Variable::POSITIVE)) {
+            if (value[literal] == Variable::POSITIVE) {
                 clauseIsPositive = true;
                 break;
-            } else if ((literal < 0 && model[-literal] == Variable::UNKNOWN) ||
-                       (literal > 0 && model[literal] == Variable::UNKNOWN)) {
+            } else if (value[literal] == Variable::UNKNOWN) {
                 clauseMayBePositive = true;
             }
         }
@@ -502,3 +1279,39 @@ SolverResult GraspTwlImplementation::canBeModelOfSatInstance() const
     }
     return formulaIsPositive ? SolverResult::SAT : SolverResult::UNKNOWN;
 }
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+constexpr unsigned GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::noReason;
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+constexpr unsigned GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::cardinalityReason;
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+constexpr unsigned GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::xorReason;
+
+template<typename LiteralT, typename Stats, typename Proof, typename Checks>
+constexpr bool GraspTwlImplementation<LiteralT, Stats, Proof, Checks>::countsStatistics;
+
+template
+class GraspTwlImplementation<int16_t, NoStatistics, NoProof>;
+
+template
+class GraspTwlImplementation<int16_t, NoStatistics, DratProof>;
+
+template
+class GraspTwlImplementation<int16_t, CountingStatistics, NoProof>;
+
+template
+class GraspTwlImplementation<int16_t, CountingStatistics, DratProof>;
+
+template
+class GraspTwlImplementation<int32_t, NoStatistics, NoProof>;
+
+template
+class GraspTwlImplementation<int32_t, NoStatistics, DratProof>;
+
+template
+class GraspTwlImplementation<int32_t, CountingStatistics, NoProof>;
+
+template
+class GraspTwlImplementation<int32_t, CountingStatistics, DratProof>;
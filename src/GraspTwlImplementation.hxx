@@ -1,28 +1,59 @@
 #ifndef FREAKSATSOLVER_GRASPTWLIMPLEMENTATION_HXX
 #define FREAKSATSOLVER_GRASPTWLIMPLEMENTATION_HXX
 
+#include <cstdint>
 #include <vector>
 #include <unordered_set>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+#include <chrono>
 #include "SolverResult.hxx"
 #include "Variable.hxx"
 #include "Solver.hxx"
+#include "Budget.hxx"
+#include "Statistics.hxx"
+#include "EnginePolicies.hxx"
+#include "ChaffTwoWatchedLiterals.hxx"
+#include "ProbSatImplementation.hxx"
+#include "CardinalityPropagator.hxx"
+#include "XorPropagator.hxx"
+#include "Checkpoint.hxx"
+#include "ResultCache.hxx"
 
 class Solver;
 
 /**
  * This is Grasp/Chaff implementation with UP on TWL, 1-UIP learning SAT Solver implementation.
+ * @c LiteralT is signed type able to represent literals in range [-nbVariables - 1; nbVariables + 1] (int16_t for
+ * small instances halves clause database). Instantiated in GraspTwlImplementation.cxx for combinations chosen by
+ * @c Solver::runEngine.
  */
+template<typename LiteralT = std::int32_t, typename StatisticsPolicy = CountingStatistics,
+        typename ProofPolicy = NoProof, typename AssertionPolicy = DefaultAssertions>
 class GraspTwlImplementation
 {
+public:
+    typedef std::function<bool(const std::vector<Variable> &phases)> RestartHook;
+
+private:
+    typedef LiteralT Literal;
+    typedef std::vector<Literal> ClauseRepresentation;
+
     Solver &satInstance;
-    std::vector<Variable> model; // variable -> variable value
-    std::vector<int> delta;      // variable -> delta(variable)
+    std::vector<ClauseRepresentation> formula; // original clauses followed by learned ones
+    std::vector<Variable> values; // literal -> literal value, both polarities kept up to date
+    Variable *value;              // values shifted such that value[l] is value of literal l
+    std::vector<int> delta;      // variable -> delta(variable), highest level of its reason for implied variable
     std::vector<unsigned> vsidsCounter;
+    std::vector<Variable> phases;       // variable -> saved phase, value assigned when variable is decided
+    std::vector<Variable> targetPhases; // variable -> value in largest conflict-free assignment, UNKNOWN if none
+    std::vector<Variable> bestPhases;   // variable -> value in largest conflict-free assignment since best rephase
+    RestartHook restartHook;
+    std::mt19937 engine; // engines of independent components run concurrently, so no shared state
 
-    typedef Solver::Literal Literal; // NOTE type is from SAT instance, this class needs type of instance (template)
-    typedef Solver::Clause ClauseRepresentation;
-
-    friend class ChaffTwoWatchedLiterals;
+    friend class ChaffTwoWatchedLiterals<GraspTwlImplementation>;
 
     enum ImplementationResult
     {
@@ -37,50 +68,311 @@ class GraspTwlImplementation
     struct TrailNode
     {
         std::vector<Literal> truthAssignment; // assignment from single UP
+        unsigned xorReasons = 0;              // reason snapshots of XOR propagator taken before this level
     };
 
+    /**
+     * Assignment undone by backjump, replayed when its reason becomes unit again
+     */
+    struct SavedAssignment
+    {
+        Literal literal;
+        unsigned reason; // clause index or noReason for decision
+    };
+
+    static constexpr unsigned noReason = ~0u;
+    static constexpr unsigned cardinalityReason = ~0u - 1; // implied by cardinality constraint, see constraintReason
+    static constexpr unsigned xorReason = ~0u - 2;         // implied by XOR row, see constraintReason
+
     std::vector<TrailNode> trail;
+    std::vector<unsigned> reason; // variable -> clause which implied it, noReason or constraint marker (while assigned)
+    std::vector<SavedAssignment> savedTrail; // stack, back is earliest undone assignment
+    int backtrackLevel = -1;             // assignments of levels up to it survive unwinding after conflict
+    std::vector<Literal> keptAssignments; // assignments surviving erased levels, moved to level search continues at
     std::vector<std::vector<Literal>> implicationGraph;
+    std::vector<bool> impliedByUnitClause; // variable -> assigned from unit clause, so it never enters learned clause
     const Literal conflictVertexIdx;
     ClauseRepresentation clauseFromConflict;
     unsigned clauseGeneration = 0;
     unsigned databaseVersion = 0;
     bool restartTakesPlace;
-    unsigned restartFactor = 100;
+    unsigned restartFactor = 100; // conflicts of stable mode restart
     unsigned conflictCounter;
+    bool budgetExhausted = false;
+    bool emptyClauseLearned = false;
+    Budget budget;
+    StatisticsPolicy statistics;
+    ProofPolicy proof;
+    ChaffTwoWatchedLiterals<GraspTwlImplementation> twl;
+    std::vector<unsigned> shortClauses; // clauses with less than two literals, not watched
+    unsigned lastLearnedClause = noReason;
+    std::vector<bool> addedClauses;     // clause -> added by addClause, kept by garbage collection like original ones
+    std::vector<Literal> assumptions;   // decided in order before any other decision
+    std::size_t nextAssumption = 0;     // assumptions before it hold, reset whenever assignments are undone
+    std::vector<int> failedAssumptions; // assumptions which cannot hold together, filled when search fails on them
+
+    // VMTF queue of variables ordered by bump time, decisions take last unassigned variable
+    std::vector<Literal> queuePrev; // variable -> variable bumped before it or 0
+    std::vector<Literal> queueNext; // variable -> variable bumped after it or 0
+    std::vector<unsigned long long> queueStamp; // variable -> bump time
+    unsigned long long queueTime = 0;
+    Literal queueFirst = 0;
+    Literal queueLast = 0;
+    Literal queueSearch = 0; // all variables after it are assigned
+
+    bool stable; // current search mode
+    unsigned long long conflicts = 0; // over all restarts, statistics policy may not count
+    unsigned long long modeLimit;     // conflicts at which search mode switches
+    unsigned long long modeLength = 700;
+    unsigned long long rephaseLimit;  // conflicts at which phases are reset
+    unsigned rephaseCount = 0;
+    unsigned restartLimit;            // conflicts of current restart
+    unsigned long long sliceLimit = std::numeric_limits<unsigned long long>::max(); // conflicts at which run suspends
+    bool suspended = false;
+    unsigned focusedRestarts = 0;
+    std::size_t targetAssigned = 0;
+    std::size_t bestAssigned = 0;
+    std::unique_ptr<ProbSatImplementation> walker; // walk rephase, created on first use
+
+    CardinalityPropagator cardinalities;
+    XorPropagator xors;
+    std::vector<ConstraintImplication> implied; // literals implied by constraints, not assigned yet
+    std::vector<unsigned> constraintReason;     // variable -> propagator reason, expanded by conflict analysis
+    std::vector<unsigned long long> assignedAt; // variable -> assignment time, kept only for cardinality reasons
+    unsigned long long assignmentTime = 0;
+    std::vector<int> explanation;
+
+    std::unique_ptr<CheckpointWriter> checkpointWriter; // null if checkpoints are disabled
+    std::chrono::steady_clock::time_point nextCheckpoint;
+    FormulaKey formulaKey; // checkpoint belongs to instance with exactly same clauses and numbering
 
 public:
+    static constexpr bool countsStatistics = StatisticsPolicy::counting;
+
     GraspTwlImplementation(Solver &satInstance);
 
+    GraspTwlImplementation(const GraspTwlImplementation &) = delete; // value points into values
+
+    GraspTwlImplementation &operator=(const GraspTwlImplementation &) = delete;
+
+    /**
+     * Searches until result is known, budget runs out or slice limit is reached. Suspended search keeps learned
+     * clauses, activities and phases, next call resumes it.
+     */
     SolverResult trySolve();
 
+    /**
+     * Next @c trySolve suspends at first restart after @c conflicts more conflicts, 0 removes limit
+     */
+    void setSliceLimit(unsigned long long conflicts);
+
+    /**
+     * Last @c trySolve returned UNKNOWN because slice ended, not because budget was exhausted
+     */
+    bool isSuspended() const;
+
     const std::vector<Variable> getModel() const;
 
-    Variable literalValue(Literal l) const;
+    /**
+     * Following @c trySolve calls search only for models where all @c assumptions hold. Learned clauses do not depend
+     * on assumptions, so they are kept when assumptions change.
+     */
+    void setAssumptions(const std::vector<int> &assumptions);
+
+    /**
+     * Assumptions which cannot hold together if last @c trySolve returned UNSAT because of them, empty if formula
+     * itself is unsatisfiable
+     */
+    const std::vector<int> &getFailedAssumptions() const;
+
+    /**
+     * Adds clause which following @c trySolve calls have to satisfy, called between them. Clause need not be implied
+     * by formula (blocking clause), so it is never collected.
+     */
+    void addClause(const std::vector<int> &clause);
+
+    /**
+     * Literals of last model on @c projected variables which unit propagation of the model cannot derive from the
+     * others. Every model containing them agrees with last model on all projected variables, so their negation blocks
+     * exactly models with the same projection.
+     */
+    std::vector<int> getModelCube(const std::vector<bool> &projected);
+
+    /**
+     * Single load, conflict vertex is always UNKNOWN
+     */
+    Variable literalValue(Literal l) const
+    {
+        return value[l];
+    }
+
+    const Statistics &getStatistics() const;
+
+    /**
+     * Sets values given to decided variables. UNKNOWN entries keep previous phase. Seeded phases take precedence over
+     * target phases of stable mode and are kept at least until next rephase interval passes.
+     */
+    void setPhases(const std::vector<Variable> &phases);
+
+    /**
+     * @c hook is invoked on every restart with saved phases (last value of every variable, assignment itself is
+     * already undone). If it returns true, hook found model by other means and @c trySolve returns SAT.
+     */
+    void setRestartHook(RestartHook hook);
+
+    /**
+     * Name of resource which stopped search with UNKNOWN result or nullptr
+     */
+    const char *getExhaustedResource() const;
 
 private:
 
+    /**
+     * Checks budget. Returns true if search has to unwind (restart, budget exhausted or UNSAT proved)
+     */
+    bool searchInterrupted();
+
+    /**
+     * Called between restarts. Switches search mode and resets phases when their conflict limits are reached.
+     */
+    void updateSearchMode();
+
+    /**
+     * Replaces saved phases by next entry of schedule original, inverted, best, walk, best, random
+     */
+    void rephase();
+
+    /**
+     * Saved phases improved by ProbSAT seeded with them
+     */
+    void walkPhases();
+
+    /**
+     * Remembers conflict-free part of assignment (levels below @c d) if it is largest seen
+     */
+    void updateTargetPhases(unsigned d);
+
+    /**
+     * Warm start from checkpoint of the same formula, if there is one. Damaged checkpoint is ignored.
+     */
+    void resumeFromCheckpoint();
+
+    /**
+     * Hands state to checkpoint writer, called between restarts when nothing is assigned
+     */
+    void saveCheckpoint();
+
+    /**
+     * Most recently bumped unassigned variable or 0 if all are assigned
+     */
+    Literal nextQueueVariable();
+
+    /**
+     * Unassigned variable with maximal VSIDS counter (random among equal) or 0 if all are assigned
+     */
+    Literal nextVsidsVariable();
+
+    /**
+     * Moves variables of @c clause to the end of VMTF queue
+     */
+    void bumpQueue(const ClauseRepresentation &clause);
+
+    void enqueue(Literal variable);
+
+    void dequeue(Literal variable);
+
     ImplementationResult search(unsigned d, unsigned &beta);
 
     VsidsResult decide(unsigned d);
 
     ImplementationResult deduce(unsigned d);
 
+    /**
+     * Assigns last unknown literal of clause or reports conflict if clause is empty
+     */
+    ImplementationResult propagateIfUnit(unsigned clauseIdx, unsigned d);
+
+    /**
+     * Assigns @c l implied by clause while search is at level @c d. Level of @c l is highest level of other literals
+     * of clause, which is lower than @c d after chronological backtracking.
+     */
+    void imply(Literal l, unsigned clauseIdx, unsigned d);
+
+    void findShortClauses();
+
+    /**
+     * Propagates @c l which became true through cardinality and XOR constraints
+     */
+    ImplementationResult propagateConstraints(Literal l, unsigned d);
+
+    /**
+     * Assigns literals of constraints which hold without any assignment (bound 0, single variable XOR rows)
+     */
+    ImplementationResult propagateConstraintUnits(unsigned d);
+
+    /**
+     * Assigns literals implied by propagator of @c kind (cardinalityReason or xorReason) or records its conflict
+     */
+    ImplementationResult implyByConstraints(unsigned kind, unsigned conflict, unsigned d);
+
+    void recordConstraintConflict(unsigned kind, unsigned conflict);
+
+    /**
+     * Collects decided assumptions which imply negation of @c assumption (and @c assumption itself) into
+     * @c failedAssumptions
+     */
+    void analyzeFailedAssumption(Literal assumption);
+
+    /**
+     * Returns true if @c variable is implied by reason consisting of projected variables and variables implied this
+     * way. @c state memoizes variables evaluated by previous calls.
+     */
+    bool isFixedByProjection(Literal variable, const std::vector<bool> &projected, std::vector<char> &state);
+
+    /**
+     * Lazy reason. Fills implication graph of variable implied by constraint.
+     */
+    void expandReason(Literal variable);
+
+    /**
+     * Learns clause from conflict found at level @c d and sets @c beta to level where search continues by asserting
+     * it: level after second highest level of clause (backjump), or conflict level itself (chronological backtrack by
+     * one level) if backjump would be longer than chronological threshold. Returns CONFLICT if empty clause is learned.
+     */
     ImplementationResult diagnose(unsigned d, unsigned &beta);
 
-    void erase();
+    /**
+     * Removes assignments of current level. Assignments of levels up to @c backtrackLevel are moved to
+     * @c keptAssignments instead. If @c save removed ones are pushed to saved trail.
+     */
+    void erase(bool save);
+
+    /**
+     * Trail saving. Reassigns saved literals whose reasons are unit again, stops at unassigned saved decision.
+     */
+    ImplementationResult replaySavedTrail(unsigned d);
+
+    /**
+     * Returns true if all literals of reason clause except @c l are false
+     */
+    bool isReasonOf(unsigned clauseIdx, Literal l) const;
 
     void recordConflict(unsigned clauseIdx);
 
     void recordVariable(Literal l, unsigned clauseIdx);
 
-    const ClauseRepresentation &getConflictInducedClause(unsigned d);
+    /**
+     * Resolves conflict at level @c conflictLevel until single literal of the level (its decision) remains. If
+     * literals of the level turn out to be implied by lower levels only, analysis continues at the highest of them,
+     * @c conflictLevel is updated.
+     */
+    const ClauseRepresentation &getConflictInducedClause(int &conflictLevel);
 
     void updateClauseDatabase(const ClauseRepresentation &newClause, unsigned d);
 
     void removeConflictVertex(unsigned d);
 
-    void firstUip(Literal l, std::vector<bool> &V);
+    void firstUip(Literal l, int conflictLevel, std::vector<bool> &V);
 
     void maybeGarbargeCollect();
 
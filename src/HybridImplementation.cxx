@@ -0,0 +1,56 @@
+#include <algorithm>
+#include "HybridImplementation.hxx"
+#include "Solver.hxx"
+
+using namespace std;
+
+HybridImplementation::HybridImplementation(Solver &satInstance) : cdcl(satInstance), localSearch(satInstance),
+                                                                  flipsPerRound(max<unsigned long long>(
+                                                                          100000, 10ull * satInstance.nbClauses))
+{ }
+
+SolverResult HybridImplementation::trySolve()
+{
+    auto result = localSearch.trySolve(flipsPerRound);
+    if (result != SolverResult::UNKNOWN) {
+        solvedByLocalSearch = true;
+        return result;
+    }
+    cdcl.setPhases(localSearch.getBestModel());
+    cdcl.setRestartHook([this](const vector<Variable> &phases) { return exchangePhases(phases); });
+    return cdcl.trySolve();
+}
+
+const vector<Variable> HybridImplementation::getModel() const
+{
+    return solvedByLocalSearch ? localSearch.getModel() : cdcl.getModel();
+}
+
+Statistics HybridImplementation::getStatistics() const
+{
+    Statistics statistics = cdcl.getStatistics();
+    statistics.flips = localSearch.getStatistics().flips;
+    return statistics;
+}
+
+const char *HybridImplementation::getExhaustedResource() const
+{
+    return cdcl.getExhaustedResource() ? cdcl.getExhaustedResource() : localSearch.getExhaustedResource();
+}
+
+bool HybridImplementation::exchangePhases(const vector<Variable> &phases)
+{
+    auto conflicts = cdcl.getStatistics().conflicts;
+    if (conflicts < nextExchange) {
+        return false; // focused CDCL restarts too often to pay for local search round every time
+    }
+    nextExchange = conflicts + exchangeInterval;
+    exchangeInterval += exchangeInterval / 2;
+    localSearch.setPhases(phases);
+    if (localSearch.trySolve(flipsPerRound) == SolverResult::SAT) {
+        solvedByLocalSearch = true;
+        return true;
+    }
+    cdcl.setPhases(localSearch.getBestModel());
+    return false;
+}
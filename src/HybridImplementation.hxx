@@ -0,0 +1,48 @@
+#ifndef FREAKSATSOLVER_HYBRIDIMPLEMENTATION_HXX
+#define FREAKSATSOLVER_HYBRIDIMPLEMENTATION_HXX
+
+#include <vector>
+#include "SolverResult.hxx"
+#include "Variable.hxx"
+#include "Statistics.hxx"
+#include "GraspTwlImplementation.hxx"
+#include "ProbSatImplementation.hxx"
+
+class Solver;
+
+/**
+ * Alternates ProbSAT and Grasp/Chaff CDCL. On CDCL restart local search is seeded with CDCL saved phases
+ * and runs for a bounded number of flips, then CDCL continues deciding with phases taken from the best local search
+ * assignment. Phases equal to a model lead CDCL to that model without conflicts.
+ */
+class HybridImplementation
+{
+    GraspTwlImplementation<> cdcl;
+    ProbSatImplementation localSearch;
+    unsigned long long flipsPerRound;
+    unsigned long long exchangeInterval = 100; // conflicts between rounds, grows geometrically
+    unsigned long long nextExchange = 0;
+    bool solvedByLocalSearch = false;
+
+public:
+    HybridImplementation(Solver &satInstance);
+
+    SolverResult trySolve();
+
+    const std::vector<Variable> getModel() const;
+
+    Statistics getStatistics() const;
+
+    const char *getExhaustedResource() const;
+
+private:
+    /**
+     * Runs one local search round seeded by CDCL @c phases and seeds CDCL phases with its result. Skipped on restarts
+     * which come sooner than @c exchangeInterval conflicts after previous round. Returns true if local search found
+     * model.
+     */
+    bool exchangePhases(const std::vector<Variable> &phases);
+};
+
+
+#endif //FREAKSATSOLVER_HYBRIDIMPLEMENTATION_HXX
@@ -0,0 +1,358 @@
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <ostream>
+#include "MaxSatImplementation.hxx"
+#include "Solver.hxx"
+
+using namespace std;
+
+constexpr unsigned MaxSatImplementation::noTotalizer;
+constexpr unsigned MaxSatImplementation::noNode;
+constexpr size_t MaxSatImplementation::coreEncodingBudget;
+constexpr size_t MaxSatImplementation::linearEncodingBudget;
+
+MaxSatImplementation::MaxSatImplementation(Solver &satInstance, std::ostream &out)
+        : satInstance(satInstance), out(out), start(chrono::steady_clock::now()),
+          nbUsedVariables(satInstance.nbVariables)
+{
+    for (auto &soft : satInstance.softClauses) {
+        if (soft.literals.empty()) {
+            baseCost += soft.weight;
+            continue;
+        }
+        Literal literal = soft.literals[0];
+        if (soft.literals.size() > 1) {
+            // engine does not exist yet, relaxation clauses become its original clauses
+            Literal relaxation = ++nbUsedVariables;
+            addedClauses.push_back(soft.literals);
+            addedClauses.back().push_back(relaxation);
+            literal = -relaxation;
+        }
+        assume(literal, soft.weight, noTotalizer, 0);
+    }
+    for (auto &assumption : assumptions) {
+        objective.emplace_back(assumption.literal, assumption.weight);
+    }
+    lowerBound = baseCost;
+    rebuild(nbUsedVariables + max<Literal>(1024, 2 * assumptions.size()));
+}
+
+SolverResult MaxSatImplementation::trySolve()
+{
+    if (satInstance.options.maxSatAlgorithm == MaxSatAlgorithm::CORE_GUIDED) {
+        return coreGuidedSearch();
+    }
+    auto result = solve({});
+    if (result != SolverResult::SAT || cost == lowerBound) {
+        return result;
+    }
+    encodeObjective(cost - baseCost, false);
+    return linearSearch();
+}
+
+SolverResult MaxSatImplementation::coreGuidedSearch()
+{
+    // stratification, assumptions of lower weight join once heavier ones are satisfiable
+    unsigned long long threshold = 0;
+    for (auto &assumption : assumptions) {
+        threshold = max(threshold, assumption.weight);
+    }
+    for (;;) {
+        vector<Literal> assumed;
+        unsigned long long nextThreshold = 0;
+        for (auto &assumption : assumptions) {
+            if (assumption.weight >= threshold && assumption.weight > 0) {
+                assumed.push_back(assumption.literal);
+            } else if (assumption.weight > 0) {
+                nextThreshold = max(nextThreshold, assumption.weight);
+            }
+        }
+        auto result = solve(assumed);
+        if (result == SolverResult::UNKNOWN) {
+            return result;
+        }
+        if (result == SolverResult::SAT) {
+            if (nextThreshold == 0) {
+                // all assumptions hold, model costs exactly the cores found
+                assert(cost == lowerBound);
+                return SolverResult::SAT;
+            }
+            threshold = nextThreshold;
+            continue;
+        }
+        auto core = cdcl->getFailedAssumptions(); // copy, engine may be rebuilt while core is processed
+        if (core.empty()) {
+            return SolverResult::UNSAT;
+        }
+        processCore(core);
+        if (cost == lowerBound) {
+            return SolverResult::SAT;
+        }
+        if (encodingClauses > coreEncodingBudget && !bestModel.empty() && encodeObjective(cost - baseCost, true)) {
+            return linearSearch();
+        }
+    }
+}
+
+SolverResult MaxSatImplementation::linearSearch()
+{
+    for (;;) {
+        if (cost == lowerBound) {
+            return SolverResult::SAT;
+        }
+        vector<Literal> bound;
+        for (auto &output : objectiveOutputs) {
+            if (baseCost + output.first >= cost) {
+                bound.push_back(-output.second);
+            }
+        }
+        auto result = solve(bound);
+        if (result == SolverResult::UNSAT) {
+            lowerBound = cost;
+            return SolverResult::SAT;
+        }
+        if (result == SolverResult::UNKNOWN) {
+            return result;
+        }
+    }
+}
+
+SolverResult MaxSatImplementation::solve(const std::vector<Literal> &assumed)
+{
+    cdcl->setAssumptions(assumed);
+    auto result = cdcl->trySolve();
+    if (result == SolverResult::SAT) {
+        recordModel();
+    }
+    return result;
+}
+
+void MaxSatImplementation::recordModel()
+{
+    auto model = cdcl->getModel();
+    unsigned long long modelCost = 0;
+    for (auto &soft : satInstance.softClauses) {
+        bool satisfied = any_of(soft.literals.begin(), soft.literals.end(), [&model](Literal l) {
+            return model[abs(l)] == (l > 0 ? Variable::POSITIVE : Variable::NEGATIVE);
+        });
+        if (!satisfied) {
+            modelCost += soft.weight;
+        }
+    }
+    if (modelCost < cost) {
+        cost = modelCost;
+        model.resize(satInstance.nbVariables + 1); // spare and encoding variables
+        bestModel = move(model);
+        out << "o " << cost << '\n';
+        out.flush();
+    }
+}
+
+void MaxSatImplementation::processCore(const std::vector<int> &core)
+{
+    auto minWeight = numeric_limits<unsigned long long>::max();
+    for (auto l : core) {
+        minWeight = min(minWeight, assumptions[assumptionIndex.at(l)].weight);
+    }
+    lowerBound += minWeight;
+    vector<Literal> violated;
+    for (auto l : core) {
+        auto &assumption = assumptions[assumptionIndex.at(l)];
+        assumption.weight -= minWeight;
+        violated.push_back(-l);
+        if (assumption.totalizer != noTotalizer) {
+            // one more violated input is paid for
+            auto totalizer = assumption.totalizer;
+            auto bound = assumption.bound + 1;
+            auto root = totalizerRoots[totalizer];
+            if (bound < totalizerNodes[root].size) {
+                extendTotalizer(root, bound + 1);
+                assume(-totalizerNodes[root].outputs[bound], minWeight, totalizer, bound);
+            }
+        }
+    }
+    if (violated.size() == 1) {
+        addClause(violated); // formula implies it
+        return;
+    }
+    // at most one of core members is violated at cost of this core
+    auto root = buildTotalizer(violated, 0, violated.size());
+    extendTotalizer(root, 2);
+    totalizerRoots.push_back(root);
+    assume(-totalizerNodes[root].outputs[1], minWeight, totalizerRoots.size() - 1, 1);
+}
+
+void MaxSatImplementation::assume(Literal literal, unsigned long long weight, unsigned totalizer, unsigned bound)
+{
+    auto known = assumptionIndex.find(literal);
+    if (known != assumptionIndex.end()) {
+        assumptions[known->second].weight += weight;
+        return;
+    }
+    assumptionIndex[literal] = assumptions.size();
+    assumptions.push_back({literal, weight, totalizer, bound});
+}
+
+unsigned MaxSatImplementation::buildTotalizer(const std::vector<Literal> &inputs, std::size_t begin, std::size_t end)
+{
+    TotalizerNode node;
+    node.size = end - begin;
+    node.left = node.right = noNode;
+    if (node.size == 1) {
+        node.outputs.push_back(inputs[begin]);
+    } else {
+        auto middle = begin + node.size / 2;
+        node.left = buildTotalizer(inputs, begin, middle);
+        node.right = buildTotalizer(inputs, middle, end);
+    }
+    totalizerNodes.push_back(move(node));
+    return totalizerNodes.size() - 1;
+}
+
+void MaxSatImplementation::extendTotalizer(unsigned node, unsigned limit)
+{
+    auto target = min(limit, totalizerNodes[node].size);
+    if (totalizerNodes[node].left == noNode || totalizerNodes[node].outputs.size() >= target) {
+        return;
+    }
+    auto left = totalizerNodes[node].left, right = totalizerNodes[node].right;
+    extendTotalizer(left, limit);
+    extendTotalizer(right, limit);
+    // children outputs added now count more inputs than any existing output, so only new outputs need clauses
+    for (size_t j = totalizerNodes[node].outputs.size() + 1; j <= target; ++j) {
+        auto output = newVariable();
+        totalizerNodes[node].outputs.push_back(output);
+        auto &leftOutputs = totalizerNodes[left].outputs;
+        auto &rightOutputs = totalizerNodes[right].outputs;
+        for (size_t i = j > rightOutputs.size() ? j - rightOutputs.size() : 0; i <= min(j, leftOutputs.size()); ++i) {
+            Clause clause;
+            if (i > 0) {
+                clause.push_back(-leftOutputs[i - 1]);
+            }
+            if (j - i > 0) {
+                clause.push_back(-rightOutputs[j - i - 1]);
+            }
+            clause.push_back(output);
+            addClause(move(clause));
+            encodingClauses += 1;
+        }
+    }
+}
+
+bool MaxSatImplementation::encodeObjective(unsigned long long limit, bool bounded)
+{
+    // clauses of abandoned encoding only imply its outputs, they never constrain search
+    typedef vector<pair<unsigned long long, Literal>> Sums; // sum -> literal implied by at least this sum
+    vector<Sums> layer;
+    for (auto &term : objective) {
+        layer.push_back({{min(term.second, limit), -term.first}});
+    }
+    size_t clauses = 0;
+    while (layer.size() > 1) {
+        vector<Sums> next;
+        for (size_t k = 0; k + 1 < layer.size(); k += 2) {
+            map<unsigned long long, Literal> merged;
+            Sums left = layer[k], right = layer[k + 1];
+            left.emplace_back(0, 0); // no input below node is violated
+            right.emplace_back(0, 0);
+            for (auto &a : left) {
+                for (auto &b : right) {
+                    if (a.first + b.first == 0) {
+                        continue;
+                    }
+                    auto sum = min(a.first + b.first, limit);
+                    auto &output = merged[sum];
+                    if (output == 0) {
+                        output = newVariable();
+                    }
+                    Clause clause;
+                    if (a.second != 0) {
+                        clause.push_back(-a.second);
+                    }
+                    if (b.second != 0) {
+                        clause.push_back(-b.second);
+                    }
+                    clause.push_back(output);
+                    addClause(move(clause));
+                    if (bounded && ++clauses > linearEncodingBudget) {
+                        return false;
+                    }
+                }
+            }
+            next.emplace_back(merged.begin(), merged.end());
+        }
+        if (layer.size() % 2 == 1) {
+            next.push_back(move(layer.back()));
+        }
+        layer = move(next);
+    }
+    objectiveOutputs = layer.empty() ? Sums() : move(layer[0]);
+    return true;
+}
+
+MaxSatImplementation::Literal MaxSatImplementation::newVariable()
+{
+    if (nbUsedVariables == working->nbVariables) {
+        rebuild(2 * working->nbVariables);
+    }
+    return ++nbUsedVariables;
+}
+
+void MaxSatImplementation::addClause(Clause clause)
+{
+    cdcl->addClause(clause);
+    addedClauses.push_back(move(clause));
+}
+
+void MaxSatImplementation::rebuild(Literal nbVariables)
+{
+    // limits apply to whole optimization, not to single engine
+    SolverOptions options = satInstance.options;
+    auto &limits = options.limits;
+    if (cdcl) {
+        retiredStatistics += cdcl->getStatistics();
+    }
+    if (limits.timeLimit > 0) {
+        auto elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        limits.timeLimit = max(limits.timeLimit - elapsed, 1e-9);
+    }
+    if (limits.conflictLimit > 0) {
+        limits.conflictLimit -= min(limits.conflictLimit - 1, retiredStatistics.conflicts);
+    }
+    if (limits.propagationLimit > 0) {
+        limits.propagationLimit -= min(limits.propagationLimit - 1, retiredStatistics.propagations);
+    }
+    auto formula = satInstance.formula;
+    formula.insert(formula.end(), addedClauses.begin(), addedClauses.end());
+    cdcl = nullptr; // refers to working instance
+    working.reset(new Solver(move(formula), nbVariables, options));
+    cdcl.reset(new GraspTwlImplementation<>(*working));
+}
+
+const vector<Variable> MaxSatImplementation::getModel() const
+{
+    return bestModel;
+}
+
+unsigned long long MaxSatImplementation::getCost() const
+{
+    return cost;
+}
+
+unsigned long long MaxSatImplementation::getLowerBound() const
+{
+    return lowerBound;
+}
+
+Statistics MaxSatImplementation::getStatistics() const
+{
+    Statistics statistics = retiredStatistics;
+    statistics += cdcl->getStatistics();
+    return statistics;
+}
+
+const char *MaxSatImplementation::getExhaustedResource() const
+{
+    return cdcl->getExhaustedResource();
+}
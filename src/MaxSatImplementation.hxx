@@ -0,0 +1,156 @@
+#ifndef FREAKSATSOLVER_MAXSATIMPLEMENTATION_HXX
+#define FREAKSATSOLVER_MAXSATIMPLEMENTATION_HXX
+
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "SolverResult.hxx"
+#include "Variable.hxx"
+#include "Statistics.hxx"
+#include "GraspTwlImplementation.hxx"
+
+class Solver;
+
+/**
+ * MaxSAT of weighted instance on incremental CDCL engine. Soft clauses become assumptions (unit soft clause its
+ * literal, longer one negated relaxation variable). Core-guided search (OLL with stratification by weight) turns
+ * every core of failed assumptions into lower bound increase and totalizer bounding number of violated core members,
+ * totalizers are extended as their bounds are relaxed. Linear SAT-UNSAT search bounds cost by generalized totalizer
+ * of all soft clauses. Every model of better cost is reported as "o COST" line right away.
+ * Engine cannot add variables, so it is created with spare variables and rebuilt with twice as many once they run out
+ * (learned clauses are lost then).
+ */
+class MaxSatImplementation
+{
+    typedef int Literal;
+    typedef std::vector<Literal> Clause;
+
+    static constexpr unsigned noTotalizer = ~0u;
+    static constexpr unsigned noNode = ~0u;
+    static constexpr std::size_t coreEncodingBudget = 1000000;   // clauses of totalizers before linear search
+    static constexpr std::size_t linearEncodingBudget = 4000000; // clauses of objective encoding of fallback
+
+    /**
+     * Literal which should hold, its violation costs @c weight
+     */
+    struct Assumption
+    {
+        Literal literal;
+        unsigned long long weight;
+        unsigned totalizer; // literal is negated output of totalizer (at most @c bound inputs true) or noTotalizer
+        unsigned bound;
+    };
+
+    /**
+     * Totalizer node, outputs[j] is implied by at least j + 1 true inputs below node. Leaf output is input itself.
+     */
+    struct TotalizerNode
+    {
+        std::vector<Literal> outputs;
+        unsigned size;  // inputs below node
+        unsigned left;  // noNode for leaf
+        unsigned right;
+    };
+
+    Solver &satInstance;
+    std::ostream &out;
+    std::unique_ptr<Solver> working; // hard and added clauses as of last rebuild, spare variables
+    std::unique_ptr<GraspTwlImplementation<>> cdcl;
+    Statistics retiredStatistics;    // of engines replaced by rebuild
+    std::chrono::steady_clock::time_point start;
+    Literal nbUsedVariables;
+    std::vector<Clause> addedClauses; // relaxation and encoding clauses, replayed by rebuild
+    std::size_t encodingClauses = 0;
+
+    std::vector<Assumption> assumptions;
+    std::unordered_map<Literal, std::size_t> assumptionIndex; // literal -> position in assumptions
+    std::vector<std::pair<Literal, unsigned long long>> objective; // initial assumptions and their weights
+    std::vector<TotalizerNode> totalizerNodes;
+    std::vector<unsigned> totalizerRoots;
+    std::vector<std::pair<unsigned long long, Literal>> objectiveOutputs; // sum -> literal implied by cost >= sum
+
+    unsigned long long baseCost = 0; // empty soft clauses
+    unsigned long long lowerBound = 0;
+    unsigned long long cost = std::numeric_limits<unsigned long long>::max(); // of best model
+    std::vector<Variable> bestModel; // empty until first model
+
+public:
+    MaxSatImplementation(Solver &satInstance, std::ostream &out);
+
+    /**
+     * Returns SAT once best model is proved optimal, UNSAT if hard clauses are unsatisfiable, UNKNOWN if budget ran
+     * out (best model so far is kept)
+     */
+    SolverResult trySolve();
+
+    /**
+     * Model of lowest cost found, empty if there is none
+     */
+    const std::vector<Variable> getModel() const;
+
+    unsigned long long getCost() const;
+
+    unsigned long long getLowerBound() const;
+
+    Statistics getStatistics() const;
+
+    const char *getExhaustedResource() const;
+
+private:
+    SolverResult coreGuidedSearch();
+
+    /**
+     * Lowers cost bound below best model until it is unsatisfiable, needs model and objective encoding
+     */
+    SolverResult linearSearch();
+
+    /**
+     * Runs engine under @c assumed, records model if it is better
+     */
+    SolverResult solve(const std::vector<Literal> &assumed);
+
+    void recordModel();
+
+    /**
+     * Raises lower bound by minimal weight of core, relaxes totalizers of core and bounds violated core members
+     */
+    void processCore(const std::vector<int> &core);
+
+    /**
+     * Adds @c weight to assumption of @c literal, creates it if it does not exist
+     */
+    void assume(Literal literal, unsigned long long weight, unsigned totalizer, unsigned bound);
+
+    /**
+     * Creates totalizer node over inputs[begin, end), without outputs above leaves
+     */
+    unsigned buildTotalizer(const std::vector<Literal> &inputs, std::size_t begin, std::size_t end);
+
+    /**
+     * Encodes outputs of @c node up to @c limit inputs
+     */
+    void extendTotalizer(unsigned node, unsigned limit);
+
+    /**
+     * Generalized totalizer of objective, sums from @c limit up share single output. Returns false if encoding
+     * exceeds its budget and @c bounded is set.
+     */
+    bool encodeObjective(unsigned long long limit, bool bounded);
+
+    Literal newVariable();
+
+    void addClause(Clause clause);
+
+    /**
+     * Replaces engine by one with @c nbVariables variables, hard and added clauses
+     */
+    void rebuild(Literal nbVariables);
+};
+
+
+#endif //FREAKSATSOLVER_MAXSATIMPLEMENTATION_HXX
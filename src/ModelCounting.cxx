@@ -0,0 +1,410 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <boost/functional/hash.hpp>
+#include "ModelCounting.hxx"
+#include "ComponentDecomposition.hxx"
+
+using namespace std;
+
+ModelCounting::ModelCounting(Solver &satInstance) : satInstance(satInstance)
+{ }
+
+SolverResult ModelCounting::trySolve()
+{
+    auto start = chrono::steady_clock::now();
+    auto &options = satInstance.options;
+    ComponentDecomposition decomposition(satInstance, true);
+    if (decomposition.isUnsatisfiable()) {
+        modelCount = 0;
+        return SolverResult::UNSAT;
+    }
+    auto &components = decomposition.getComponents();
+    // variables neither fixed nor occurring in any component double the count
+    size_t freeVariables = satInstance.nbVariables;
+    for (Literal i = 1; i <= satInstance.nbVariables; ++i) {
+        freeVariables -= decomposition.getFixedVariables()[i] != Variable::UNKNOWN;
+    }
+    for (auto &component : components) {
+        freeVariables -= component.variables.size();
+    }
+
+    size_t nbWorkers = max<size_t>(1, min<size_t>(options.threads, components.size()));
+    vector<Count> counts(components.size());
+    vector<Statistics> componentStatistics(components.size());
+    vector<const char *> exhausted(components.size(), nullptr);
+    auto cancellation = options.cancellation.child(); // cancelled by first component without model
+    atomic<size_t> nextComponent(0);
+    auto worker = [&]() {
+        for (size_t i; (i = nextComponent++) < components.size();) {
+            auto limits = options.limits;
+            if (limits.timeLimit > 0) {
+                // time limit applies to whole formula
+                limits.timeLimit -= chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                if (limits.timeLimit <= 0) {
+                    exhausted[i] = "time";
+                    continue;
+                }
+            }
+            Counter counter(move(components[i].formula), components[i].variables.size(), limits, cancellation,
+                            options.countCacheSize / nbWorkers);
+            counts[i] = counter.count();
+            componentStatistics[i] = counter.getStatistics();
+            if (counter.isBudgetExhausted()) {
+                exhausted[i] = counter.getExhaustedResource();
+            } else if (counts[i] == 0) {
+                cancellation.cancel();
+            }
+        }
+    };
+    vector<thread> workers;
+    for (size_t i = 1; i < nbWorkers; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto &t : workers) {
+        t.join();
+    }
+
+    for (size_t i = 0; i < components.size(); ++i) {
+        statistics += componentStatistics[i];
+        if (!exhausted[i] && counts[i] == 0) {
+            modelCount = 0;
+            return SolverResult::UNSAT; // other components may be cancelled
+        }
+    }
+    for (size_t i = 0; i < components.size(); ++i) {
+        if (exhausted[i]) {
+            exhaustedResource = exhausted[i];
+            return SolverResult::UNKNOWN;
+        }
+    }
+    modelCount = Count(1) << freeVariables;
+    for (auto &count : counts) {
+        modelCount *= count;
+    }
+    return SolverResult::SAT;
+}
+
+const ModelCounting::Count &ModelCounting::getModelCount() const
+{
+    return modelCount;
+}
+
+const vector<Variable> ModelCounting::getModel() const
+{
+    return {};
+}
+
+const Statistics &ModelCounting::getStatistics() const
+{
+    return statistics;
+}
+
+const char *ModelCounting::getExhaustedResource() const
+{
+    return exhaustedResource;
+}
+
+ModelCounting::Counter::Counter(Formula formula, Literal nbVariables, const ResourceLimits &limits,
+                                const CancellationToken &cancellation, std::size_t cacheLimit)
+        : nbVariables(nbVariables), values(nbVariables + 1, Variable::UNKNOWN), watches(2 * (nbVariables + 1)),
+          cacheLimit(cacheLimit), parent(nbVariables + 1), stamp(nbVariables + 1), partOf(nbVariables + 1),
+          score(nbVariables + 1), budget(limits, cancellation)
+{
+    for (auto &clause : formula) {
+        sort(clause.begin(), clause.end(), [](Literal a, Literal b) {
+            return abs(a) < abs(b) || (abs(a) == abs(b) && a < b);
+        });
+        clause.erase(unique(clause.begin(), clause.end()), clause.end());
+        bool tautology = false;
+        for (size_t i = 1; i < clause.size(); ++i) {
+            tautology = tautology || clause[i] == -clause[i - 1];
+        }
+        if (tautology) {
+            continue;
+        }
+        if (clause.empty()) {
+            conflictAtRoot = true;
+        } else if (clause.size() == 1) {
+            units.push_back(clauses.size());
+        } else {
+            watches[watchIndex(clause[0])].push_back(clauses.size());
+            watches[watchIndex(clause[1])].push_back(clauses.size());
+        }
+        clauses.push_back(move(clause));
+    }
+}
+
+ModelCounting::Count ModelCounting::Counter::count()
+{
+    if (conflictAtRoot) {
+        return 0;
+    }
+    for (auto clauseIdx : units) {
+        Literal l = clauses[clauseIdx][0];
+        auto value = literalValue(l);
+        if (value == Variable::NEGATIVE || (value == Variable::UNKNOWN && !propagate(l))) {
+            return 0;
+        }
+    }
+    Component formula;
+    for (Literal i = 1; i <= nbVariables; ++i) {
+        formula.variables.push_back(i);
+    }
+    for (unsigned i = 0; i < clauses.size(); ++i) {
+        formula.clauses.push_back(i);
+    }
+    return countSplit(formula);
+}
+
+bool ModelCounting::Counter::isBudgetExhausted() const
+{
+    return budgetExhausted;
+}
+
+const Statistics &ModelCounting::Counter::getStatistics() const
+{
+    return statistics;
+}
+
+const char *ModelCounting::Counter::getExhaustedResource() const
+{
+    return budget.getExhaustedResource();
+}
+
+ModelCounting::Count ModelCounting::Counter::countComponent(const Component &component)
+{
+    vector<Literal> key(component.variables);
+    for (auto clauseIdx : component.clauses) {
+        key.push_back(-static_cast<Literal>(clauseIdx) - 1);
+    }
+    if (auto cached = lookup(key)) {
+        return *cached;
+    }
+    if (budget.isExhausted(statistics)) {
+        budgetExhausted = true;
+        return 0;
+    }
+    // branch on variable occurring in most clauses of component, clauses shortened by assignment weigh far more, so
+    // that search stays next to assigned variables and cuts component apart
+    constexpr unsigned shortenedWeight = 100;
+    for (auto v : component.variables) {
+        score[v] = 0;
+    }
+    for (auto clauseIdx : component.clauses) {
+        auto &clause = clauses[clauseIdx];
+        bool shortened = any_of(clause.begin(), clause.end(), [this](Literal l) {
+            return values[abs(l)] != Variable::UNKNOWN;
+        });
+        for (auto l : clause) {
+            score[abs(l)] += shortened ? shortenedWeight : 1; // score of assigned variable is not read
+        }
+    }
+    auto byScore = [this](Literal a, Literal b) {
+        return score[a] < score[b];
+    };
+    Literal variable = *max_element(component.variables.begin(), component.variables.end(), byScore);
+    Count total = 0;
+    for (Literal decision : {variable, -variable}) {
+        statistics.decisions += 1;
+        auto marker = trail.size();
+        if (propagate(decision)) {
+            total += countSplit(component);
+        } else {
+            statistics.conflicts += 1;
+        }
+        undo(marker);
+        if (budgetExhausted) {
+            return 0; // partial count must not be cached
+        }
+    }
+    store(move(key), total);
+    return total;
+}
+
+size_t ModelCounting::Counter::split(const Component &component, std::vector<Component> &result)
+{
+    ++currentStamp;
+    for (auto v : component.variables) {
+        parent[v] = v;
+    }
+    // union-find over unassigned variables of each clause which is not satisfied
+    vector<pair<unsigned, Literal>> active; // clause, its unassigned variable
+    for (auto clauseIdx : component.clauses) {
+        Literal first = 0;
+        bool satisfied = false;
+        for (auto l : clauses[clauseIdx]) {
+            auto value = literalValue(l);
+            if (value == Variable::POSITIVE) {
+                satisfied = true;
+                break;
+            } else if (value == Variable::UNKNOWN) {
+                if (first) {
+                    parent[find(abs(l))] = find(first);
+                } else {
+                    first = abs(l);
+                }
+            }
+        }
+        if (!satisfied) {
+            assert(first != 0); // propagation is complete, so clause has at least two unassigned literals
+            active.emplace_back(clauseIdx, first);
+        }
+    }
+    for (auto &clause : active) {
+        auto root = find(clause.second);
+        if (stamp[root] != currentStamp) {
+            stamp[root] = currentStamp; // root owns part
+            partOf[root] = result.size();
+            result.emplace_back();
+        }
+        result[partOf[root]].clauses.push_back(clause.first);
+    }
+    size_t freeVariables = 0;
+    for (auto v : component.variables) {
+        if (values[v] != Variable::UNKNOWN) {
+            continue;
+        }
+        auto root = find(v);
+        if (stamp[root] == currentStamp) {
+            result[partOf[root]].variables.push_back(v);
+        } else {
+            freeVariables += 1;
+        }
+    }
+    return freeVariables;
+}
+
+ModelCounting::Count ModelCounting::Counter::countSplit(const Component &component)
+{
+    vector<Component> parts;
+    Count result = Count(1) << split(component, parts);
+    for (auto &part : parts) {
+        result *= countComponent(part);
+        if (result == 0) {
+            break;
+        }
+    }
+    return result;
+}
+
+bool ModelCounting::Counter::propagate(Literal literal)
+{
+    auto head = trail.size();
+    values[abs(literal)] = literal > 0 ? Variable::POSITIVE : Variable::NEGATIVE;
+    trail.push_back(literal);
+    for (; head < trail.size(); ++head) {
+        Literal falsified = -trail[head];
+        auto &watching = watches[watchIndex(falsified)];
+        size_t kept = 0;
+        for (size_t i = 0; i < watching.size(); ++i) {
+            auto &clause = clauses[watching[i]];
+            if (clause[0] == falsified) {
+                swap(clause[0], clause[1]);
+            }
+            if (literalValue(clause[0]) == Variable::POSITIVE) {
+                watching[kept++] = watching[i];
+                continue;
+            }
+            auto replacement = find_if(clause.begin() + 2, clause.end(), [this](Literal l) {
+                return literalValue(l) != Variable::NEGATIVE;
+            });
+            if (replacement != clause.end()) {
+                swap(clause[1], *replacement);
+                watches[watchIndex(clause[1])].push_back(watching[i]);
+                continue;
+            }
+            watching[kept++] = watching[i];
+            if (literalValue(clause[0]) == Variable::NEGATIVE) {
+                // watches not visited yet stay
+                for (++i; i < watching.size(); ++i) {
+                    watching[kept++] = watching[i];
+                }
+                watching.resize(kept);
+                return false;
+            }
+            values[abs(clause[0])] = clause[0] > 0 ? Variable::POSITIVE : Variable::NEGATIVE;
+            trail.push_back(clause[0]);
+            statistics.propagations += 1;
+        }
+        watching.resize(kept);
+    }
+    return true;
+}
+
+void ModelCounting::Counter::undo(std::size_t marker)
+{
+    for (auto l = trail.begin() + marker; l != trail.end(); ++l) {
+        values[abs(*l)] = Variable::UNKNOWN;
+    }
+    trail.resize(marker);
+}
+
+Variable ModelCounting::Counter::literalValue(Literal l) const
+{
+    Variable value = values[abs(l)];
+    if (l < 0 && value != Variable::UNKNOWN) {
+        value = value == Variable::POSITIVE ? Variable::NEGATIVE : Variable::POSITIVE;
+    }
+    return value;
+}
+
+size_t ModelCounting::Counter::watchIndex(Literal l)
+{
+    return 2 * static_cast<size_t>(abs(l)) + (l < 0);
+}
+
+const ModelCounting::Count *ModelCounting::Counter::lookup(const std::vector<Literal> &key)
+{
+    auto found = cacheIndex.find(&key);
+    if (found == cacheIndex.end()) {
+        return nullptr;
+    }
+    cache.splice(cache.begin(), cache, found->second);
+    return &found->second->count;
+}
+
+void ModelCounting::Counter::store(std::vector<Literal> key, const Count &count)
+{
+    if (cacheLimit == 0) {
+        return;
+    }
+    cache.push_front({move(key), count});
+    cacheIndex.emplace(&cache.front().key, cache.begin());
+    cacheBytes += entryBytes(cache.front());
+    while (cacheBytes > cacheLimit && cache.size() > 1) {
+        cacheBytes -= entryBytes(cache.back());
+        cacheIndex.erase(&cache.back().key);
+        cache.pop_back();
+    }
+}
+
+size_t ModelCounting::Counter::entryBytes(const CacheEntry &entry)
+{
+    constexpr size_t nodeOverhead = 96; // list node, index node and bucket
+    return sizeof(CacheEntry) + nodeOverhead + entry.key.size() * sizeof(Literal) +
+           entry.count.backend().size() * sizeof(boost::multiprecision::limb_type);
+}
+
+ModelCounting::Literal ModelCounting::Counter::find(Literal variable)
+{
+    while (parent[variable] != variable) {
+        parent[variable] = parent[parent[variable]]; // path halving
+        variable = parent[variable];
+    }
+    return variable;
+}
+
+size_t ModelCounting::Counter::KeyHash::operator()(const std::vector<Literal> *key) const
+{
+    return boost::hash_range(key->begin(), key->end());
+}
+
+bool ModelCounting::Counter::KeyEqual::operator()(const std::vector<Literal> *a, const std::vector<Literal> *b) const
+{
+    return *a == *b;
+}
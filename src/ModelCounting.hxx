@@ -0,0 +1,169 @@
+#ifndef FREAKSATSOLVER_MODELCOUNTING_HXX
+#define FREAKSATSOLVER_MODELCOUNTING_HXX
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <boost/multiprecision/cpp_int.hpp>
+#include "SolverResult.hxx"
+#include "Variable.hxx"
+#include "Statistics.hxx"
+#include "Budget.hxx"
+#include "Solver.hxx"
+
+/**
+ * Exact model counting (#SAT). Formula is simplified by unit propagation and split into variable-disjoint components,
+ * which are counted in parallel by workers of options. Each component is counted by DPLL with unit propagation on two
+ * watched literals, which splits residual formula into components again after every decision (dynamic decomposition)
+ * and multiplies their counts. Counts of components are cached, cache is bounded in memory and evicts least recently
+ * used entries.
+ */
+class ModelCounting
+{
+public:
+    typedef boost::multiprecision::cpp_int Count;
+
+private:
+    typedef Solver::Literal Literal;
+    typedef Solver::Clause Clause;
+    typedef Solver::Formula Formula;
+
+    /**
+     * Counts models of single formula, variables numbered from 1
+     */
+    class Counter
+    {
+        /**
+         * Unassigned variables and not satisfied clauses (indices into clauses) which share no variable with rest of
+         * formula, both sorted
+         */
+        struct Component
+        {
+            std::vector<Literal> variables;
+            std::vector<unsigned> clauses;
+        };
+
+        struct CacheEntry
+        {
+            std::vector<Literal> key; // variables of component, then clauses as -(index + 1)
+            Count count;
+        };
+
+        struct KeyHash
+        {
+            std::size_t operator()(const std::vector<Literal> *key) const;
+        };
+
+        struct KeyEqual
+        {
+            bool operator()(const std::vector<Literal> *a, const std::vector<Literal> *b) const;
+        };
+
+        Literal nbVariables;
+        Formula clauses;                            // duplicate literals removed, tautologies dropped
+        std::vector<Variable> values;
+        std::vector<Literal> trail;                 // assigned literals in order, undone down to marker of decision
+        std::vector<std::vector<unsigned>> watches; // literal -> clauses watching it, kept across backtracking
+        std::vector<unsigned> units;                // clauses of single literal
+        bool conflictAtRoot = false;
+
+        std::list<CacheEntry> cache;                // most recently used first
+        std::unordered_map<const std::vector<Literal> *, std::list<CacheEntry>::iterator, KeyHash, KeyEqual>
+                cacheIndex;
+        std::size_t cacheBytes = 0;
+        std::size_t cacheLimit;
+
+        // scratch space of split and branching, indexed by variable
+        std::vector<Literal> parent;    // union-find forest
+        std::vector<unsigned> stamp;    // equals currentStamp at root which owns part of current split
+        std::vector<std::size_t> partOf;
+        unsigned currentStamp = 0;
+        std::vector<unsigned> score;    // weighted clauses of component containing variable
+
+        Budget budget;
+        Statistics statistics;
+        bool budgetExhausted = false;
+
+    public:
+        Counter(Formula formula, Literal nbVariables, const ResourceLimits &limits,
+                const CancellationToken &cancellation, std::size_t cacheLimit);
+
+        /**
+         * Number of models, only valid unless budget ran out. Called once, assignment of level 0 stays.
+         */
+        Count count();
+
+        bool isBudgetExhausted() const;
+
+        const Statistics &getStatistics() const;
+
+        const char *getExhaustedResource() const;
+
+    private:
+        Count countComponent(const Component &component);
+
+        /**
+         * Splits unassigned variables and not satisfied clauses of @c component into components, returns number of
+         * unassigned variables which occur in no such clause
+         */
+        std::size_t split(const Component &component, std::vector<Component> &result);
+
+        /**
+         * Product of counts of @c component split by current assignment, stops at first component without model
+         */
+        Count countSplit(const Component &component);
+
+        /**
+         * Assigns @c literal and propagates it, returns false on conflict
+         */
+        bool propagate(Literal literal);
+
+        /**
+         * Unassigns literals of trail from @c marker on
+         */
+        void undo(std::size_t marker);
+
+        Variable literalValue(Literal l) const;
+
+        static std::size_t watchIndex(Literal l);
+
+        const Count *lookup(const std::vector<Literal> &key);
+
+        /**
+         * Inserts entry as most recently used, evicts least recently used entries beyond memory limit
+         */
+        void store(std::vector<Literal> key, const Count &count);
+
+        static std::size_t entryBytes(const CacheEntry &entry);
+
+        Literal find(Literal variable);
+    };
+
+    Solver &satInstance;
+    Count modelCount;
+    Statistics statistics;
+    const char *exhaustedResource = nullptr;
+
+public:
+    ModelCounting(Solver &satInstance);
+
+    /**
+     * SAT if formula has models, UNSAT if it has none, UNKNOWN if budget ran out in any component
+     */
+    SolverResult trySolve();
+
+    const Count &getModelCount() const;
+
+    /**
+     * Counting produces no model, returns empty vector
+     */
+    const std::vector<Variable> getModel() const;
+
+    const Statistics &getStatistics() const;
+
+    const char *getExhaustedResource() const;
+};
+
+
+#endif //FREAKSATSOLVER_MODELCOUNTING_HXX
@@ -0,0 +1,70 @@
+#include <ostream>
+#include "ModelEnumeration.hxx"
+#include "Solver.hxx"
+
+using namespace std;
+
+ModelEnumeration::ModelEnumeration(Solver &satInstance, std::ostream &out) : satInstance(satInstance),
+                                                                             cdcl(satInstance), out(out)
+{
+    auto &projection = satInstance.projection;
+    projected.assign(satInstance.nbVariables + 1, projection.empty());
+    for (auto variable : projection) {
+        projected[variable] = true;
+    }
+    projected[0] = false;
+}
+
+SolverResult ModelEnumeration::trySolve()
+{
+    auto maxModels = satInstance.options.maxModels;
+    while (maxModels == 0 || modelCount < maxModels) {
+        auto result = cdcl.trySolve();
+        if (result == SolverResult::UNSAT) {
+            return modelCount > 0 ? SolverResult::SAT : SolverResult::UNSAT;
+        }
+        if (result == SolverResult::UNKNOWN) {
+            return result;
+        }
+        if (modelCount++ == 0) {
+            out << "SAT\n";
+        }
+        model = cdcl.getModel();
+        for (int variable = 1; variable <= satInstance.nbVariables; ++variable) {
+            if (!projected[variable]) {
+                model[variable] = Variable::UNKNOWN;
+            }
+        }
+        Solver::printModel(model, out);
+        out.flush(); // consumer processes models while enumeration goes on
+        auto blockingClause = cdcl.getModelCube(projected);
+        if (blockingClause.empty()) {
+            return SolverResult::SAT; // projection is implied by formula, no other exists
+        }
+        for (auto &l : blockingClause) {
+            l = -l;
+        }
+        cdcl.addClause(blockingClause);
+    }
+    return SolverResult::SAT;
+}
+
+unsigned long long ModelEnumeration::getModelCount() const
+{
+    return modelCount;
+}
+
+const vector<Variable> ModelEnumeration::getModel() const
+{
+    return model;
+}
+
+const Statistics &ModelEnumeration::getStatistics() const
+{
+    return cdcl.getStatistics();
+}
+
+const char *ModelEnumeration::getExhaustedResource() const
+{
+    return cdcl.getExhaustedResource();
+}
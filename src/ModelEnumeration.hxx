@@ -0,0 +1,50 @@
+#ifndef FREAKSATSOLVER_MODELENUMERATION_HXX
+#define FREAKSATSOLVER_MODELENUMERATION_HXX
+
+#include <iosfwd>
+#include <vector>
+#include "SolverResult.hxx"
+#include "Variable.hxx"
+#include "Statistics.hxx"
+#include "GraspTwlImplementation.hxx"
+
+class Solver;
+
+/**
+ * Enumerates models by single incremental CDCL engine, each model is printed as soon as it is found and blocked by
+ * clause. Models are projected onto "c p show" variables of instance (all variables without them), so printed models
+ * are distinct on projection. Blocking clause holds only projected literals which propagation cannot derive from
+ * the others.
+ */
+class ModelEnumeration
+{
+    Solver &satInstance;
+    GraspTwlImplementation<> cdcl;
+    std::vector<bool> projected; // variable -> printed and blocked
+    std::ostream &out;
+    std::vector<Variable> model; // last projected model
+    unsigned long long modelCount = 0;
+
+public:
+    ModelEnumeration(Solver &satInstance, std::ostream &out);
+
+    /**
+     * Prints "SAT" before first model and every model found. Returns SAT if enumeration finished (all models or
+     * limit of options printed), UNSAT if there is no model, UNKNOWN if budget ran out.
+     */
+    SolverResult trySolve();
+
+    unsigned long long getModelCount() const;
+
+    /**
+     * Last printed model, variables outside projection are UNKNOWN
+     */
+    const std::vector<Variable> getModel() const;
+
+    const Statistics &getStatistics() const;
+
+    const char *getExhaustedResource() const;
+};
+
+
+#endif //FREAKSATSOLVER_MODELENUMERATION_HXX
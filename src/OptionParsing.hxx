@@ -0,0 +1,33 @@
+#ifndef FREAKSATSOLVER_OPTIONPARSING_HXX
+#define FREAKSATSOLVER_OPTIONPARSING_HXX
+
+#include <string>
+#include <boost/lexical_cast.hpp>
+
+/**
+ * Parses value of @c --name=value argument into @c value. Returns false if @c argument is not @c name option.
+ */
+template<typename T>
+bool parseOption(const std::string &argument, const std::string &name, T &value)
+{
+    std::string prefix = "--" + name + "=";
+    if (argument.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    value = boost::lexical_cast<T>(argument.substr(prefix.size()));
+    return true;
+}
+
+/**
+ * Returns true if @c argument is @c --name flag
+ */
+inline bool parseFlag(const std::string &argument, const std::string &name, bool &value)
+{
+    if (argument != "--" + name) {
+        return false;
+    }
+    value = true;
+    return true;
+}
+
+#endif //FREAKSATSOLVER_OPTIONPARSING_HXX
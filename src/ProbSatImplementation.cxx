@@ -0,0 +1,239 @@
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include "ProbSatImplementation.hxx"
+#include "Solver.hxx"
+
+using namespace std;
+
+ProbSatImplementation::ProbSatImplementation(Solver &satInstance) : satInstance(satInstance),
+                                                                    model(satInstance.nbVariables + 1,
+                                                                          Variable::NEGATIVE),
+                                                                    occurrenceBegin(
+                                                                            2 * (satInstance.nbVariables + 1) + 1),
+                                                                    breakCount(satInstance.nbVariables + 1),
+                                                                    engine(random_device()()),
+                                                                    budget(satInstance.options.limits,
+                                                                           satInstance.options.cancellation)
+{
+    // flat deduplicated copy of formula, tautologies are always satisfied and dropped
+    size_t maxClauseSize = 0;
+    vector<char> seen(2 * (satInstance.nbVariables + 1));
+    clauseBegin.push_back(0);
+    for (auto &clause : satInstance.formula) {
+        auto begin = literals.size();
+        bool tautology = false;
+        for (auto l : clause) {
+            if (seen[literalIndex(-l)]) {
+                tautology = true;
+            }
+            if (!seen[literalIndex(l)]) {
+                seen[literalIndex(l)] = 1;
+                literals.push_back(l);
+            }
+        }
+        for (auto i = begin; i < literals.size(); ++i) {
+            seen[literalIndex(literals[i])] = 0;
+        }
+        if (tautology) {
+            literals.resize(begin);
+            continue;
+        }
+        hasEmptyClause = hasEmptyClause || literals.size() == begin;
+        maxClauseSize = max(maxClauseSize, literals.size() - begin);
+        clauseBegin.push_back(literals.size());
+    }
+    auto nbClauses = clauseBegin.size() - 1;
+    trueLiteralCount.resize(nbClauses);
+    trueVariableXor.resize(nbClauses);
+    unsatisfiedPosition.resize(nbClauses);
+
+    // occurrence lists in CSR layout
+    for (auto l : literals) {
+        occurrenceBegin[literalIndex(l) + 1] += 1;
+    }
+    for (size_t i = 1; i < occurrenceBegin.size(); ++i) {
+        occurrenceBegin[i] += occurrenceBegin[i - 1];
+    }
+    occurrences.resize(literals.size());
+    vector<unsigned> fill(occurrenceBegin.begin(), occurrenceBegin.end() - 1);
+    for (unsigned clauseIdx = 0; clauseIdx < nbClauses; ++clauseIdx) {
+        for (auto i = clauseBegin[clauseIdx]; i < clauseBegin[clauseIdx + 1]; ++i) {
+            occurrences[fill[literalIndex(literals[i])]++] = clauseIdx;
+        }
+    }
+
+    // ProbSAT parameters: polynomial break function for 3-SAT, exponential for longer clauses
+    constexpr unsigned maxTabulatedBreak = 64;
+    for (unsigned b = 0; b <= maxTabulatedBreak; ++b) {
+        if (maxClauseSize <= 3) {
+            breakWeight.push_back(pow(1.0 + b, -2.38));
+        } else {
+            breakWeight.push_back(pow(maxClauseSize < 7 ? 3.7 : 5.4, -static_cast<double>(b)));
+        }
+    }
+
+    uniform_int_distribution<int> coin(0, 1);
+    for (Literal i = 1; i <= satInstance.nbVariables; ++i) {
+        model[i] = coin(engine) ? Variable::POSITIVE : Variable::NEGATIVE;
+    }
+    initializeCounters();
+}
+
+SolverResult ProbSatImplementation::trySolve()
+{
+    return trySolve(0);
+}
+
+SolverResult ProbSatImplementation::trySolve(unsigned long long maxFlips)
+{
+    return trySolve(maxFlips, budget, statistics);
+}
+
+SolverResult ProbSatImplementation::trySolve(unsigned long long maxFlips, Budget &budget, const Statistics &charged)
+{
+    if (hasEmptyClause) {
+        return SolverResult::UNSAT;
+    }
+    for (unsigned long long flips = 0; !unsatisfiedClauses.empty(); ++flips) {
+        if ((maxFlips && flips >= maxFlips) || budget.isExhausted(charged)) {
+            return SolverResult::UNKNOWN;
+        }
+        uniform_int_distribution<size_t> chooseClause(0, unsatisfiedClauses.size() - 1);
+        flip(pickVariable(unsatisfiedClauses[chooseClause(engine)]));
+        if (unsatisfiedClauses.size() < bestUnsatisfiedCount) {
+            bestUnsatisfiedCount = unsatisfiedClauses.size();
+            bestModel = model;
+        }
+    }
+    bestModel = model;
+    return SolverResult::SAT;
+}
+
+void ProbSatImplementation::setPhases(const std::vector<Variable> &phases)
+{
+    assert(phases.size() == model.size());
+    for (Literal i = 1; i <= satInstance.nbVariables; ++i) {
+        if (phases[i] != Variable::UNKNOWN) {
+            model[i] = phases[i];
+        }
+    }
+    initializeCounters();
+}
+
+const vector<Variable> ProbSatImplementation::getModel() const
+{
+    return model;
+}
+
+const vector<Variable> &ProbSatImplementation::getBestModel() const
+{
+    return bestModel;
+}
+
+const Statistics &ProbSatImplementation::getStatistics() const
+{
+    return statistics;
+}
+
+const char *ProbSatImplementation::getExhaustedResource() const
+{
+    return budget.getExhaustedResource();
+}
+
+unsigned ProbSatImplementation::literalIndex(Literal l)
+{
+    return 2 * abs(l) + (l < 0);
+}
+
+bool ProbSatImplementation::isTrue(Literal l) const
+{
+    return model[abs(l)] == (l > 0 ? Variable::POSITIVE : Variable::NEGATIVE);
+}
+
+void ProbSatImplementation::initializeCounters()
+{
+    fill(breakCount.begin(), breakCount.end(), 0);
+    unsatisfiedClauses.clear();
+    for (unsigned clauseIdx = 0; clauseIdx < trueLiteralCount.size(); ++clauseIdx) {
+        trueLiteralCount[clauseIdx] = 0;
+        trueVariableXor[clauseIdx] = 0;
+        for (auto i = clauseBegin[clauseIdx]; i < clauseBegin[clauseIdx + 1]; ++i) {
+            if (isTrue(literals[i])) {
+                trueLiteralCount[clauseIdx] += 1;
+                trueVariableXor[clauseIdx] ^= abs(literals[i]);
+            }
+        }
+        if (trueLiteralCount[clauseIdx] == 0) {
+            makeUnsatisfied(clauseIdx);
+        } else if (trueLiteralCount[clauseIdx] == 1) {
+            breakCount[trueVariableXor[clauseIdx]] += 1;
+        }
+    }
+    bestUnsatisfiedCount = unsatisfiedClauses.size();
+    bestModel = model;
+}
+
+ProbSatImplementation::Literal ProbSatImplementation::pickVariable(unsigned clauseIdx)
+{
+    candidateWeight.clear();
+    double sum = 0;
+    for (auto i = clauseBegin[clauseIdx]; i < clauseBegin[clauseIdx + 1]; ++i) {
+        auto b = min<size_t>(breakCount[abs(literals[i])], breakWeight.size() - 1);
+        sum += breakWeight[b];
+        candidateWeight.push_back(sum);
+    }
+    uniform_real_distribution<double> roulette(0, sum);
+    auto chosen = upper_bound(candidateWeight.begin(), candidateWeight.end(), roulette(engine)) -
+                  candidateWeight.begin();
+    chosen = min<ptrdiff_t>(chosen, candidateWeight.size() - 1);
+    return abs(literals[clauseBegin[clauseIdx] + chosen]);
+}
+
+void ProbSatImplementation::flip(Literal variable)
+{
+    assert(variable > 0);
+    statistics.flips += 1;
+    Literal becomesTrue = model[variable] == Variable::POSITIVE ? -variable : variable;
+    model[variable] = becomesTrue > 0 ? Variable::POSITIVE : Variable::NEGATIVE;
+    auto index = literalIndex(becomesTrue);
+    for (auto i = occurrenceBegin[index]; i < occurrenceBegin[index + 1]; ++i) {
+        auto clauseIdx = occurrences[i];
+        auto count = trueLiteralCount[clauseIdx]++;
+        if (count == 0) {
+            makeSatisfied(clauseIdx);
+            breakCount[variable] += 1;
+        } else if (count == 1) {
+            breakCount[trueVariableXor[clauseIdx]] -= 1; // previous only true variable is no longer critical
+        }
+        trueVariableXor[clauseIdx] ^= variable;
+    }
+    index = literalIndex(-becomesTrue);
+    for (auto i = occurrenceBegin[index]; i < occurrenceBegin[index + 1]; ++i) {
+        auto clauseIdx = occurrences[i];
+        auto count = --trueLiteralCount[clauseIdx];
+        trueVariableXor[clauseIdx] ^= variable;
+        if (count == 0) {
+            makeUnsatisfied(clauseIdx);
+            breakCount[variable] -= 1;
+        } else if (count == 1) {
+            breakCount[trueVariableXor[clauseIdx]] += 1;
+        }
+    }
+}
+
+void ProbSatImplementation::makeSatisfied(unsigned clauseIdx)
+{
+    auto position = unsatisfiedPosition[clauseIdx];
+    auto last = unsatisfiedClauses.back();
+    unsatisfiedClauses[position] = last;
+    unsatisfiedPosition[last] = position;
+    unsatisfiedClauses.pop_back();
+}
+
+void ProbSatImplementation::makeUnsatisfied(unsigned clauseIdx)
+{
+    unsatisfiedPosition[clauseIdx] = unsatisfiedClauses.size();
+    unsatisfiedClauses.push_back(clauseIdx);
+}
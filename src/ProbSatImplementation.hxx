@@ -0,0 +1,100 @@
+#ifndef FREAKSATSOLVER_PROBSATIMPLEMENTATION_HXX
+#define FREAKSATSOLVER_PROBSATIMPLEMENTATION_HXX
+
+#include <vector>
+#include <random>
+#include "SolverResult.hxx"
+#include "Variable.hxx"
+#include "Solver.hxx"
+#include "Budget.hxx"
+#include "Statistics.hxx"
+
+class Solver;
+
+/**
+ * This is ProbSAT stochastic local search implementation. Incomplete - never proves UNSAT, returns UNKNOWN when
+ * budget runs out.
+ */
+class ProbSatImplementation
+{
+    typedef Solver::Literal Literal;
+
+    Solver &satInstance;
+    std::vector<Variable> model;     // variable -> current value, always complete
+    std::vector<Variable> bestModel; // assignment with fewest unsatisfied clauses since last seeding
+    std::size_t bestUnsatisfiedCount;
+    bool hasEmptyClause = false;
+
+    std::vector<unsigned> clauseBegin;      // clause -> begin of its literals in literals, one past end at the back
+    std::vector<Literal> literals;          // deduplicated clauses stored one after another
+    std::vector<unsigned> occurrenceBegin;  // literal index -> begin of its clauses in occurrences
+    std::vector<unsigned> occurrences;      // clause indices grouped by literal
+    std::vector<unsigned> trueLiteralCount; // clause -> number of true literals
+    std::vector<Literal> trueVariableXor;   // clause -> xor of variables of true literals, critical variable if count is 1
+    std::vector<unsigned> breakCount;       // variable -> number of clauses it is the only true variable of
+    std::vector<unsigned> unsatisfiedClauses;
+    std::vector<unsigned> unsatisfiedPosition; // clause -> position in unsatisfiedClauses
+    std::vector<double> breakWeight;           // break count -> unnormalized probability of choosing variable
+    std::vector<double> candidateWeight;
+    std::mt19937 engine;
+
+    Budget budget;
+    Statistics statistics;
+
+public:
+    ProbSatImplementation(Solver &satInstance);
+
+    /**
+     * Flips until all clauses are satisfied or budget runs out
+     */
+    SolverResult trySolve();
+
+    /**
+     * Flips at most @c maxFlips times. Returns SAT or UNKNOWN.
+     */
+    SolverResult trySolve(unsigned long long maxFlips);
+
+    /**
+     * Flips at most @c maxFlips times within @c budget of other engine, which is checked against its counters
+     * @c charged. Returns SAT or UNKNOWN.
+     */
+    SolverResult trySolve(unsigned long long maxFlips, Budget &budget, const Statistics &charged);
+
+    /**
+     * Restarts search from @c phases. Variables which are UNKNOWN in @c phases keep their current value.
+     */
+    void setPhases(const std::vector<Variable> &phases);
+
+    const std::vector<Variable> getModel() const;
+
+    /**
+     * Assignment with fewest unsatisfied clauses found since last @c setPhases
+     */
+    const std::vector<Variable> &getBestModel() const;
+
+    const Statistics &getStatistics() const;
+
+    const char *getExhaustedResource() const;
+
+private:
+
+    static unsigned literalIndex(Literal l);
+
+    bool isTrue(Literal l) const;
+
+    /**
+     * Recomputes clause counters, break counts and unsatisfied set from scratch
+     */
+    void initializeCounters();
+
+    Literal pickVariable(unsigned clauseIdx);
+
+    void flip(Literal variable);
+
+    void makeSatisfied(unsigned clauseIdx);
+
+    void makeUnsatisfied(unsigned clauseIdx);
+};
+
+
+#endif //FREAKSATSOLVER_PROBSATIMPLEMENTATION_HXX
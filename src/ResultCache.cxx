@@ -0,0 +1,445 @@
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ResultCache.hxx"
+#include "BinaryCnf.hxx"
+
+using namespace std;
+
+constexpr char ResultCache::magic[8];
+constexpr unsigned ResultCache::refinementRounds;
+constexpr uint64_t ResultCache::initialCapacity;
+
+namespace
+{
+/**
+ * Holds flock on file descriptor for its lifetime
+ */
+class FileLock
+{
+    int fd;
+
+public:
+    FileLock(int fd, int operation) : fd(fd)
+    {
+        while (flock(fd, operation) != 0) {
+            if (errno != EINTR) {
+                throw system_error(errno, system_category(), "Unable to lock result cache");
+            }
+        }
+    }
+
+    ~FileLock()
+    {
+        flock(fd, LOCK_UN);
+    }
+};
+
+constexpr uint64_t hashBasis0 = 14695981039346656037ull;
+constexpr uint64_t hashBasis1 = 0x6A09E667F3BCC908ull;
+
+void mix(uint64_t hash[2], int64_t value)
+{
+    // two independent FNV-1a style streams make 128-bit key
+    hash[0] = (hash[0] ^ static_cast<uint64_t>(value)) * 1099511628211ull;
+    hash[1] = (hash[1] ^ static_cast<uint64_t>(value)) * 0x9E3779B97F4A7C15ull;
+    hash[1] ^= hash[1] >> 29;
+}
+}
+
+ResultCache::ResultCache(const std::string &path)
+{
+    indexFd = open((path + ".idx").c_str(), O_RDWR | O_CREAT, 0644);
+    if (indexFd < 0) {
+        throw system_error(errno, system_category(), "Unable to open result cache >" + path + ".idx<");
+    }
+    dataFd = open((path + ".dat").c_str(), O_RDWR | O_CREAT, 0644);
+    if (dataFd < 0) {
+        auto error = errno;
+        close(indexFd);
+        throw system_error(error, system_category(), "Unable to open result cache >" + path + ".dat<");
+    }
+}
+
+ResultCache::~ResultCache()
+{
+    close(dataFd);
+    close(indexFd);
+}
+
+CanonicalFormula ResultCache::canonicalFormula(const Solver &satInstance)
+{
+    CanonicalFormula formula;
+    auto colors = refineColors(satInstance);
+    vector<pair<uint64_t, Solver::Literal>> order;
+    for (Solver::Literal v = 1; v <= satInstance.nbVariables; ++v) {
+        order.emplace_back(colors[v], v);
+    }
+    sort(order.begin(), order.end());
+    formula.renaming.resize(satInstance.nbVariables + 1);
+    for (size_t i = 0; i < order.size(); ++i) {
+        formula.renaming[order[i].second] = i + 1;
+    }
+    auto &renaming = formula.renaming;
+    auto rename = [&renaming](vector<Solver::Literal> literals) {
+        for (auto &l : literals) {
+            l = l > 0 ? renaming[l] : -renaming[-l];
+        }
+        sort(literals.begin(), literals.end());
+        return literals;
+    };
+
+    auto &words = formula.words;
+    words.push_back(satInstance.nbVariables);
+    vector<Solver::Clause> clauses;
+    for (unsigned i = 0; i < satInstance.nbClauses; ++i) {
+        clauses.push_back(rename(satInstance.formula[i]));
+    }
+    sort(clauses.begin(), clauses.end());
+    for (auto &clause : clauses) {
+        words.push_back(-static_cast<int64_t>(clause.size()) - 1); // never equal to literal, separates clauses
+        words.insert(words.end(), clause.begin(), clause.end());
+    }
+    vector<pair<unsigned, Solver::Clause>> cardinalities;
+    for (auto &constraint : satInstance.cardinalityConstraints) {
+        cardinalities.emplace_back(constraint.bound, rename(constraint.literals));
+    }
+    sort(cardinalities.begin(), cardinalities.end());
+    for (auto &constraint : cardinalities) {
+        words.push_back(numeric_limits<int64_t>::min());
+        words.push_back(constraint.first);
+        words.insert(words.end(), constraint.second.begin(), constraint.second.end());
+    }
+    vector<pair<bool, Solver::Clause>> xors;
+    for (auto &constraint : satInstance.xorConstraints) {
+        xors.emplace_back(constraint.parity, rename(constraint.variables));
+    }
+    sort(xors.begin(), xors.end());
+    for (auto &constraint : xors) {
+        words.push_back(numeric_limits<int64_t>::min() + 1);
+        words.push_back(constraint.first);
+        words.insert(words.end(), constraint.second.begin(), constraint.second.end());
+    }
+    formula.key = {{hashBasis0, hashBasis1}};
+    for (auto word : words) {
+        mix(formula.key.hash, word);
+    }
+    return formula;
+}
+
+ResultCache::Key ResultCache::formulaKey(const Solver &satInstance)
+{
+    Key key = {{hashBasis0, hashBasis1}};
+    mix(key.hash, satInstance.nbVariables);
+    auto mixClause = [&key](const Solver::Literal *begin, const Solver::Literal *end) {
+        mix(key.hash, -(end - begin) - 1);
+        for (auto l = begin; l != end; ++l) {
+            mix(key.hash, *l);
+        }
+    };
+    for (unsigned i = 0; i < satInstance.nbClauses; ++i) {
+        if (satInstance.snapshot) {
+            mixClause(satInstance.snapshot->clauseBegin(i), satInstance.snapshot->clauseEnd(i));
+        } else {
+            auto &clause = satInstance.formula[i];
+            mixClause(clause.data(), clause.data() + clause.size());
+        }
+    }
+    for (auto &constraint : satInstance.cardinalityConstraints) {
+        mix(key.hash, numeric_limits<int64_t>::min());
+        mix(key.hash, constraint.bound);
+        mixClause(constraint.literals.data(), constraint.literals.data() + constraint.literals.size());
+    }
+    for (auto &constraint : satInstance.xorConstraints) {
+        mix(key.hash, numeric_limits<int64_t>::min() + 1);
+        mix(key.hash, constraint.parity);
+        mixClause(constraint.variables.data(), constraint.variables.data() + constraint.variables.size());
+    }
+    return key;
+}
+
+vector<uint64_t> ResultCache::refineColors(const Solver &satInstance)
+{
+    auto nbVariables = satInstance.nbVariables;
+    // constraints with their own initial color: kind, bound or parity, size
+    vector<const vector<Solver::Literal> *> constraints;
+    vector<uint64_t> constraintTags;
+    for (unsigned i = 0; i < satInstance.nbClauses; ++i) {
+        constraints.push_back(&satInstance.formula[i]);
+        constraintTags.push_back(satInstance.formula[i].size() * 4);
+    }
+    for (auto &constraint : satInstance.cardinalityConstraints) {
+        constraints.push_back(&constraint.literals);
+        constraintTags.push_back((constraint.literals.size() * 4 + 1) ^ (uint64_t(constraint.bound) << 32));
+    }
+    for (auto &constraint : satInstance.xorConstraints) {
+        constraints.push_back(&constraint.variables);
+        constraintTags.push_back(constraint.variables.size() * 4 + 2 + constraint.parity);
+    }
+    // occurrences of variable v are occurrences[start[v]] .. occurrences[start[v + 1] - 1], negative for negated
+    vector<size_t> start(nbVariables + 2);
+    for (auto constraint : constraints) {
+        for (auto l : *constraint) {
+            ++start[abs(l) + 1];
+        }
+    }
+    for (Solver::Literal v = 1; v <= nbVariables + 1; ++v) {
+        start[v] += start[v - 1];
+    }
+    vector<int64_t> occurrences(start.back());
+    vector<size_t> next(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < constraints.size(); ++i) {
+        for (auto l : *constraints[i]) {
+            occurrences[next[abs(l)]++] = l > 0 ? int64_t(i) + 1 : -int64_t(i) - 1;
+        }
+    }
+
+    // colors are ranks of sorted signatures, so they do not depend on input numbering
+    vector<uint64_t> colors(nbVariables + 1, 0);
+    vector<uint64_t> constraintColors(constraints.size());
+    vector<uint64_t> signature;
+    vector<pair<uint64_t, Solver::Literal>> hashes(nbVariables);
+    size_t nbClasses = 1;
+    for (unsigned round = 0; round < refinementRounds && nbClasses < static_cast<size_t>(nbVariables); ++round) {
+        for (size_t i = 0; i < constraints.size(); ++i) {
+            signature.clear();
+            for (auto l : *constraints[i]) {
+                signature.push_back(colors[abs(l)] * 2 + (l < 0));
+            }
+            sort(signature.begin(), signature.end());
+            uint64_t hash[2] = {hashBasis0, constraintTags[i]};
+            for (auto word : signature) {
+                mix(hash, word);
+            }
+            constraintColors[i] = hash[0] ^ hash[1];
+        }
+        for (Solver::Literal v = 1; v <= nbVariables; ++v) {
+            signature.clear();
+            for (auto i = start[v]; i < start[v + 1]; ++i) {
+                auto occurrence = occurrences[i];
+                signature.push_back(constraintColors[abs(occurrence) - 1] * 2 + (occurrence < 0));
+            }
+            sort(signature.begin(), signature.end());
+            uint64_t hash[2] = {hashBasis0, colors[v]};
+            for (auto word : signature) {
+                mix(hash, word);
+            }
+            hashes[v - 1] = {hash[0] ^ hash[1], v};
+        }
+        sort(hashes.begin(), hashes.end());
+        size_t rank = 0;
+        for (size_t i = 0; i < hashes.size(); ++i) {
+            if (i > 0 && hashes[i].first != hashes[i - 1].first) {
+                ++rank;
+            }
+            colors[hashes[i].second] = rank;
+        }
+        if (rank + 1 == nbClasses) {
+            // Stable. Smallest class is usually orbit of symmetry, then any of its variables may be individualized
+            // without losing canonicity.
+            vector<size_t> classSize(nbClasses);
+            for (Solver::Literal v = 1; v <= nbVariables; ++v) {
+                ++classSize[colors[v]];
+            }
+            uint64_t smallest = 0;
+            for (uint64_t color = 0; color < nbClasses; ++color) {
+                if (classSize[color] > 1 && (classSize[smallest] == 1 || classSize[color] < classSize[smallest])) {
+                    smallest = color;
+                }
+            }
+            *find(colors.begin() + 1, colors.end(), smallest) = nbClasses;
+            ++rank;
+        }
+        nbClasses = rank + 1;
+    }
+    return colors;
+}
+
+bool ResultCache::lookup(const CanonicalFormula &formula, SolverResult &result, std::vector<Variable> &model)
+{
+    auto &key = formula.key;
+    uint64_t recordOffset;
+    {
+        FileLock lock(indexFd, LOCK_SH);
+        size_t size;
+        auto index = mapIndex(size, false);
+        if (!index) {
+            return false;
+        }
+        recordOffset = findSlot(index, key)->recordOffset;
+        munmap(index, size);
+    }
+    if (recordOffset == 0) {
+        return false;
+    }
+    RecordHeader record;
+    if (pread(dataFd, &record, sizeof(record), recordOffset - 1) != sizeof(record) ||
+        memcmp(record.hash, key.hash, sizeof(key.hash)) != 0 || record.nbVariables < 0) {
+        return false;
+    }
+    bool sat = record.result == static_cast<uint32_t>(SolverResult::SAT);
+    if (record.modelBytes != (sat ? static_cast<uint64_t>(record.nbVariables) / 8 + 1 : 0) ||
+        record.formulaWords != (sat ? 0 : formula.words.size())) {
+        return false;
+    }
+    auto dataOffset = recordOffset - 1 + sizeof(record);
+    if (!sat) {
+        // 128-bit hash alone is not proof of unsatisfiability
+        vector<int64_t> words(record.formulaWords);
+        auto bytes = static_cast<ssize_t>(words.size() * sizeof(int64_t));
+        if (pread(dataFd, words.data(), bytes, dataOffset) != bytes || words != formula.words) {
+            return false;
+        }
+        result = SolverResult::UNSAT;
+        model.clear();
+        return true;
+    }
+    vector<uint8_t> bits(record.modelBytes);
+    if (record.nbVariables + 1 != static_cast<int64_t>(formula.renaming.size()) ||
+        pread(dataFd, bits.data(), bits.size(), dataOffset) != static_cast<ssize_t>(bits.size())) {
+        return false;
+    }
+    result = SolverResult::SAT;
+    model.assign(record.nbVariables + 1, Variable::UNKNOWN);
+    for (int32_t i = 1; i <= record.nbVariables; ++i) {
+        auto bit = formula.renaming[i];
+        model[i] = (bits[bit / 8] >> (bit % 8)) & 1 ? Variable::POSITIVE : Variable::NEGATIVE;
+    }
+    return true;
+}
+
+void ResultCache::store(const CanonicalFormula &formula, SolverResult result, const std::vector<Variable> &model)
+{
+    auto &key = formula.key;
+    if (result == SolverResult::SAT && model.size() != formula.renaming.size()) {
+        return; // model of other formula
+    }
+    RecordHeader record = {};
+    memcpy(record.hash, key.hash, sizeof(key.hash));
+    record.result = static_cast<uint32_t>(result);
+    vector<uint8_t> payload;
+    if (result == SolverResult::SAT) {
+        // model bits in canonical numbering
+        record.nbVariables = formula.renaming.size() - 1;
+        payload.resize(record.nbVariables / 8 + 1);
+        for (int32_t i = 1; i <= record.nbVariables; ++i) {
+            auto bit = formula.renaming[i];
+            if (model[i] == Variable::POSITIVE) {
+                payload[bit / 8] |= 1 << (bit % 8);
+            }
+        }
+        record.modelBytes = payload.size();
+    } else {
+        auto bytes = reinterpret_cast<const uint8_t *>(formula.words.data());
+        payload.assign(bytes, bytes + formula.words.size() * sizeof(int64_t));
+        record.formulaWords = formula.words.size();
+    }
+
+    FileLock lock(indexFd, LOCK_EX);
+    size_t size;
+    auto index = mapIndex(size, true);
+    auto slot = findSlot(index, key);
+    if (slot->recordOffset == 0 && (index->count + 1) * 2 > index->capacity) {
+        index = grow(index, size);
+        slot = findSlot(index, key);
+    }
+    auto offset = lseek(dataFd, 0, SEEK_END);
+    if (offset < 0 || pwrite(dataFd, &record, sizeof(record), offset) != sizeof(record) ||
+        pwrite(dataFd, payload.data(), payload.size(), offset + sizeof(record)) !=
+        static_cast<ssize_t>(payload.size())) {
+        auto error = errno;
+        munmap(index, size);
+        throw system_error(error, system_category(), "Unable to write result cache record");
+    }
+    // record is complete before index points to it
+    if (slot->recordOffset == 0) {
+        index->count += 1;
+        memcpy(slot->hash, key.hash, sizeof(key.hash));
+    }
+    slot->recordOffset = offset + 1;
+    munmap(index, size);
+}
+
+ResultCache::IndexHeader *ResultCache::mapIndex(std::size_t &size, bool writable)
+{
+    struct stat status;
+    if (fstat(indexFd, &status) != 0) {
+        throw system_error(errno, system_category(), "Unable to stat result cache index");
+    }
+    size = status.st_size;
+    bool initialize = false;
+    if (size == 0) {
+        if (!writable) {
+            return nullptr;
+        }
+        size = sizeof(IndexHeader) + initialCapacity * sizeof(Slot);
+        if (ftruncate(indexFd, size) != 0) {
+            throw system_error(errno, system_category(), "Unable to create result cache index");
+        }
+        initialize = true;
+    }
+    void *mapping = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, indexFd, 0);
+    if (mapping == MAP_FAILED) {
+        throw system_error(errno, system_category(), "Unable to map result cache index");
+    }
+    auto index = static_cast<IndexHeader *>(mapping);
+    if (initialize) {
+        memcpy(index->magic, magic, sizeof(magic));
+        index->capacity = initialCapacity;
+        index->count = 0;
+    }
+    if (size < sizeof(IndexHeader) || memcmp(index->magic, magic, sizeof(magic)) != 0 ||
+        size != sizeof(IndexHeader) + index->capacity * sizeof(Slot) || (index->capacity & (index->capacity - 1))) {
+        munmap(mapping, size);
+        throw system_error(make_error_code(errc::invalid_argument), "Corrupted result cache index");
+    }
+    return index;
+}
+
+ResultCache::Slot *ResultCache::findSlot(IndexHeader *index, const Key &key)
+{
+    auto slots = reinterpret_cast<Slot *>(index + 1);
+    auto mask = index->capacity - 1;
+    for (auto i = key.hash[0] & mask;; i = (i + 1) & mask) {
+        if (slots[i].recordOffset == 0 || memcmp(slots[i].hash, key.hash, sizeof(key.hash)) == 0) {
+            return &slots[i];
+        }
+    }
+}
+
+ResultCache::IndexHeader *ResultCache::grow(IndexHeader *index, std::size_t &size)
+{
+    auto oldSlots = reinterpret_cast<Slot *>(index + 1);
+    vector<Slot> entries;
+    for (uint64_t i = 0; i < index->capacity; ++i) {
+        if (oldSlots[i].recordOffset != 0) {
+            entries.push_back(oldSlots[i]);
+        }
+    }
+    auto capacity = index->capacity * 2;
+    munmap(index, size);
+    size = sizeof(IndexHeader) + capacity * sizeof(Slot);
+    if (ftruncate(indexFd, size) != 0) {
+        throw system_error(errno, system_category(), "Unable to grow result cache index");
+    }
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, indexFd, 0);
+    if (mapping == MAP_FAILED) {
+        throw system_error(errno, system_category(), "Unable to map result cache index");
+    }
+    index = static_cast<IndexHeader *>(mapping);
+    index->capacity = capacity;
+    memset(index + 1, 0, capacity * sizeof(Slot));
+    for (auto &entry : entries) {
+        Key key = {{entry.hash[0], entry.hash[1]}};
+        *findSlot(index, key) = entry;
+    }
+    return index;
+}
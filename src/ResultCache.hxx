@@ -0,0 +1,130 @@
+#ifndef FREAKSATSOLVER_RESULTCACHE_HXX
+#define FREAKSATSOLVER_RESULTCACHE_HXX
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "SolverResult.hxx"
+#include "Variable.hxx"
+#include "Solver.hxx"
+
+/**
+ * 128-bit formula hash
+ */
+struct FormulaKey
+{
+    std::uint64_t hash[2];
+};
+
+/**
+ * Formula with variables renumbered by color refinement of variable-constraint incidence (variable colors are refined
+ * by colors and polarities of constraints they occur in until classes stop splitting), literals sorted within
+ * clauses and clauses sorted. Formulas differing by order of clauses, order of literals and numbering of variables
+ * which refinement tells apart get equal canonical form. Variables left in same class keep input order.
+ */
+struct CanonicalFormula
+{
+    FormulaKey key;
+    std::vector<int> renaming;       // variable -> canonical variable
+    std::vector<std::int64_t> words; // serialized canonical formula, @c key is its hash
+};
+
+/**
+ * On-disk cache of solver results keyed by hash of canonical formula. SAT records hold model in canonical numbering
+ * (caller verifies it), UNSAT records hold whole canonical formula which has to match, so hash collision never yields
+ * wrong UNSAT. Consists of two files: PATH.idx - open addressing hash table mapped into memory, PATH.dat - append-only
+ * records. Every operation maps index under flock, so cache may be shared by concurrent processes.
+ */
+class ResultCache
+{
+public:
+    typedef FormulaKey Key;
+
+private:
+    struct IndexHeader
+    {
+        char magic[8];
+        std::uint64_t capacity; // number of slots, power of two
+        std::uint64_t count;
+    };
+
+    struct Slot
+    {
+        std::uint64_t hash[2];
+        std::uint64_t recordOffset; // offset in data file + 1, 0 means empty slot
+    };
+
+    struct RecordHeader
+    {
+        std::uint64_t hash[2];
+        std::uint32_t result;
+        std::int32_t nbVariables;
+        std::uint64_t modelBytes;
+        std::uint64_t formulaWords; // canonical formula of UNSAT record
+    };
+
+    static constexpr char magic[8] = {'F', 'S', 'A', 'T', 'R', 'C', '0', '2'};
+    static constexpr unsigned refinementRounds = 32; // chains would need round per variable
+    static constexpr std::uint64_t initialCapacity = 1 << 12;
+
+    int indexFd = -1;
+    int dataFd = -1;
+
+public:
+    /**
+     * Opens cache at @c path, creates it if it does not exist
+     */
+    explicit ResultCache(const std::string &path);
+
+    ResultCache(const ResultCache &) = delete;
+
+    ResultCache &operator=(const ResultCache &) = delete;
+
+    ~ResultCache();
+
+    /**
+     * Canonical form of original clauses and extended constraints of @c satInstance
+     */
+    static CanonicalFormula canonicalFormula(const Solver &satInstance);
+
+    /**
+     * Hash of original clauses and extended constraints of @c satInstance exactly as given (numbering and order)
+     */
+    static Key formulaKey(const Solver &satInstance);
+
+    /**
+     * Returns true and fills @c result and @c model (in numbering of instance) if @c formula is cached. UNSAT is
+     * returned only for equal formula, model is not verified here.
+     */
+    bool lookup(const CanonicalFormula &formula, SolverResult &result, std::vector<Variable> &model);
+
+    /**
+     * Stores SAT or UNSAT result, replaces previous entry of @c formula
+     */
+    void store(const CanonicalFormula &formula, SolverResult result, const std::vector<Variable> &model);
+
+private:
+    /**
+     * Variable -> color after refinement, equal colors for variables refinement cannot tell apart
+     */
+    static std::vector<std::uint64_t> refineColors(const Solver &satInstance);
+
+    /**
+     * Maps whole index file, caller holds the lock
+     */
+    IndexHeader *mapIndex(std::size_t &size, bool writable);
+
+    /**
+     * Returns slot holding @c key or empty slot where it belongs
+     */
+    static Slot *findSlot(IndexHeader *index, const Key &key);
+
+    /**
+     * Doubles capacity of index, caller holds exclusive lock. Returns new mapping.
+     */
+    IndexHeader *grow(IndexHeader *index, std::size_t &size);
+};
+
+
+#endif //FREAKSATSOLVER_RESULTCACHE_HXX
@@ -1,23 +1,48 @@
 #include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+#include <cstdlib>
+#include <cstdint>
+#include <limits>
 #include <istream>
 #include <sstream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <memory>
 #include <boost/lexical_cast.hpp>
 #include "Solver.hxx"
 #include "DimacsFormatException.hxx"
 #include "DpllUpImplementation.hxx"
 #include "RawDpllImplementation.hxx"
 #include "GraspTwlImplementation.hxx"
+#include "ProbSatImplementation.hxx"
+#include "HybridImplementation.hxx"
+#include "BackboneComputation.hxx"
+#include "ModelEnumeration.hxx"
+#include "MaxSatImplementation.hxx"
+#include "ModelCounting.hxx"
+#include "ComponentDecomposition.hxx"
+#include "BinaryCnf.hxx"
+#include "BinaryCnfFormatException.hxx"
+#include "ResultCache.hxx"
+#include "VariableRenumbering.hxx"
+#include "SymmetryBreaking.hxx"
 
 using namespace std;
 
-Solver::Solver(std::istream &in)
+Solver::Solver(std::istream &in, const SolverOptions &options) : options(options)
 {
     std::string line;
     size_t state = 0; // 0 - ignoring comments, >0 - current clause
+    auto top = numeric_limits<unsigned long long>::max(); // weight of hard clauses
     for (; in.good();) {
         getline(in, line);
         if (state == 0) {
-            if (line[0] == 'c') {
+            if (line.compare(0, 9, "c p show ") == 0) {
+                parseProjection(line);
+            } else if (line[0] == 'c') {
                 continue; // ignore comments
             } else if (line[0] == 'p') {
                 // we have header
@@ -28,8 +53,11 @@ Solver::Solver(std::istream &in)
                     throw DimacsFormatException("Incorrect header line: >>" + line + "<<");
                 }
                 parser >> word;
-                if (word != "cnf") {
-                    throw DimacsFormatException("Incorrect instance format: >" + word + "<. Expected >cnf<");
+                if (word == "wcnf") {
+                    weighted = true;
+                } else if (word != "cnf") {
+                    throw DimacsFormatException("Incorrect instance format: >" + word + "<. Expected >cnf< or "
+                                                ">wcnf<");
                 }
                 parser >> word;
                 if (!boost::conversion::try_lexical_convert(word, nbVariables)) {
@@ -39,10 +67,32 @@ Solver::Solver(std::istream &in)
                 if (!boost::conversion::try_lexical_convert(word, nbClauses)) {
                     throw DimacsFormatException("Unable to parse clauses number: >" + word + "<");
                 }
+                // without top weight every clause is soft
+                if (weighted && parser >> word && !boost::conversion::try_lexical_convert(word, top)) {
+                    throw DimacsFormatException("Unable to parse top weight: >" + word + "<");
+                }
                 state = 1;
             } else {
                 throw DimacsFormatException("Unknown input line format: >>" + line + "<<");
             }
+        } else if (weighted) {
+            parseWeightedClause(line, top);
+            if (state == nbClauses) {
+                break;
+            }
+            state += 1;
+        } else if (line[0] == 'x') {
+            parseXorConstraint(line);
+            if (state == nbClauses) {
+                break;
+            }
+            state += 1;
+        } else if (line[0] == 'k') {
+            parseCardinalityConstraint(line);
+            if (state == nbClauses) {
+                break;
+            }
+            state += 1;
         } else {
             formula.emplace_back();
             formula.back().reserve(nbVariables);
@@ -66,14 +116,500 @@ Solver::Solver(std::istream &in)
             state += 1;
         }
     }
+    nbClauses = formula.size(); // header counts extended constraints too
+    for (auto variable : projection) {
+        if (variable <= 0 || variable > nbVariables) {
+            throw DimacsFormatException("Projected variable out of range: " + to_string(variable));
+        }
+    }
+}
+
+std::vector<Solver::Literal> Solver::parseConstraintLiterals(std::istream &parser, const std::string &line) const
+{
+    vector<Literal> literals;
+    for (;;) {
+        string word;
+        parser >> word;
+        Literal l;
+        if (!boost::conversion::try_lexical_convert(word, l)) {
+            throw DimacsFormatException("Unable to parse literal: >" + word + "<");
+        }
+        if (l == 0) {
+            return literals;
+        }
+        if (l < -nbVariables || l > nbVariables) {
+            throw DimacsFormatException("Literal out of range: >>" + line + "<<");
+        }
+        literals.push_back(l);
+    }
+}
+
+void Solver::parseXorConstraint(const std::string &line)
+{
+    istringstream parser(line.substr(1));
+    XorConstraint constraint{{}, true};
+    auto literals = parseConstraintLiterals(parser, line);
+    for (auto l : literals) {
+        constraint.parity ^= l < 0;
+        constraint.variables.push_back(abs(l));
+    }
+    // x XOR x = 0
+    sort(constraint.variables.begin(), constraint.variables.end());
+    vector<Literal> variables;
+    for (size_t i = 0; i < constraint.variables.size(); ++i) {
+        if (i + 1 < constraint.variables.size() && constraint.variables[i] == constraint.variables[i + 1]) {
+            ++i;
+        } else {
+            variables.push_back(constraint.variables[i]);
+        }
+    }
+    constraint.variables = move(variables);
+    if (!constraint.variables.empty() || constraint.parity) {
+        xorConstraints.push_back(move(constraint));
+    }
+}
+
+void Solver::parseCardinalityConstraint(const std::string &line)
+{
+    istringstream parser(line.substr(1));
+    string word;
+    parser >> word;
+    CardinalityConstraint constraint;
+    if (!boost::conversion::try_lexical_convert(word, constraint.bound)) {
+        throw DimacsFormatException("Unable to parse cardinality bound: >" + word + "<");
+    }
+    constraint.literals = parseConstraintLiterals(parser, line);
+    sort(constraint.literals.begin(), constraint.literals.end());
+    if (adjacent_find(constraint.literals.begin(), constraint.literals.end()) != constraint.literals.end()) {
+        throw DimacsFormatException("Repeated literal in cardinality constraint: >>" + line + "<<");
+    }
+    if (constraint.bound < constraint.literals.size()) {
+        cardinalityConstraints.push_back(move(constraint));
+    }
+}
+
+void Solver::parseProjection(const std::string &line)
+{
+    // variables are checked once header is known
+    istringstream parser(line.substr(9));
+    for (;;) {
+        string word;
+        parser >> word;
+        Literal variable;
+        if (!boost::conversion::try_lexical_convert(word, variable)) {
+            throw DimacsFormatException("Unable to parse projected variable: >" + word + "<");
+        }
+        if (variable == 0) {
+            return;
+        }
+        projection.push_back(variable);
+    }
+}
+
+void Solver::parseWeightedClause(const std::string &line, unsigned long long top)
+{
+    istringstream parser(line);
+    string word;
+    parser >> word;
+    unsigned long long weight;
+    if (!boost::conversion::try_lexical_convert(word, weight)) {
+        throw DimacsFormatException("Unable to parse clause weight: >" + word + "<");
+    }
+    auto literals = parseConstraintLiterals(parser, line);
+    if (weight >= top) {
+        formula.push_back(move(literals));
+    } else if (weight > 0) {
+        softClauses.push_back({move(literals), weight});
+    }
+}
+
+Solver::Solver(Formula formula, Literal nbVariables, const SolverOptions &options) : formula(move(formula)),
+                                                                                    nbVariables(nbVariables),
+                                                                                    nbClauses(this->formula.size()),
+                                                                                    options(options)
+{ }
+
+Solver::Solver(std::shared_ptr<const BinaryCnf> cnf, const SolverOptions &options)
+        : nbVariables(cnf->getNbVariables()),
+          nbClauses(cnf->getNbClauses()),
+          options(options),
+          snapshot(move(cnf))
+{
+    if (snapshot->getNbClauses() != nbClauses) {
+        throw BinaryCnfFormatException("Too many clauses: " + to_string(snapshot->getNbClauses()));
+    }
+}
+
+void Solver::loadSnapshot()
+{
+    formula.resize(nbClauses);
+    for (unsigned i = 0; i < nbClauses; ++i) {
+        checkSnapshotClause(snapshot->clauseBegin(i), snapshot->clauseEnd(i));
+        formula[i].assign(snapshot->clauseBegin(i), snapshot->clauseEnd(i));
+    }
+    snapshot = nullptr;
+}
+
+void Solver::checkSnapshotClause(const std::int32_t *begin, const std::int32_t *end) const
+{
+    for (auto l = begin; l != end; ++l) {
+        if (*l == 0 || *l < -nbVariables || *l > nbVariables) {
+            throw BinaryCnfFormatException("Literal out of range: " + to_string(*l));
+        }
+    }
+}
+
+void Solver::writeBinary(std::ostream &out) const
+{
+    BinaryCnf::write(*this, out);
 }
 
 void Solver::solve(std::ostream &out)
 {
-    //out << "c !!!WARNING!!! This is raw DPLL. Expect very long runtime\n";
-    GraspTwlImplementation impl(*this); // TODO inject implementation here
-    auto result = impl.trySolve();
-    switch (result) {
+    solveSlice(out, 0);
+}
+
+bool Solver::solveSlice(std::ostream &out, unsigned long long conflicts)
+{
+    Outcome outcome;
+    if (!suspendedRun) {
+        if ((!cardinalityConstraints.empty() || !xorConstraints.empty()) &&
+            (options.engine != SolverEngine::CDCL || options.decompose || !options.proofPath.empty() ||
+             options.task == SolverTask::COUNT || options.symmetryClauses > 0)) {
+            // symmetry detection sees clauses only
+            throw invalid_argument("XOR and cardinality constraints require cdcl engine without decomposition, "
+                                   "proof, model counting and symmetry breaking");
+        }
+        if (!projection.empty() && options.task == SolverTask::COUNT) {
+            throw invalid_argument("Model counting does not support projection");
+        }
+        if (weighted && (options.engine != SolverEngine::CDCL || options.decompose || options.renumber ||
+                         options.symmetryClauses > 0 || options.task != SolverTask::SOLVE ||
+                         !options.cachePath.empty() || !options.proofPath.empty() || !options.checkpointPath.empty())) {
+            // soft clauses are relaxed by clauses not implied by formula
+            throw invalid_argument("Weighted instances require cdcl engine without decomposition, renumbering, "
+                                   "symmetry breaking, other tasks, cache, proof and checkpoints");
+        }
+        if (snapshot && (!options.cachePath.empty() || options.renumber || options.symmetryClauses > 0 ||
+                         options.decompose || options.engine != SolverEngine::CDCL ||
+                         options.task == SolverTask::COUNT)) {
+            loadSnapshot(); // only CDCL engine reads clauses from snapshot
+        }
+        if (options.task != SolverTask::SOLVE) {
+            runTask(out);
+            return true;
+        }
+        if (weighted) {
+            runOptimization(out);
+            return true;
+        }
+        if (!options.cachePath.empty()) {
+            ResultCache cache(options.cachePath);
+            canonicalFormula = make_shared<CanonicalFormula>(ResultCache::canonicalFormula(*this));
+            if (cache.lookup(*canonicalFormula, outcome.result, outcome.model) &&
+                (outcome.result == SolverResult::UNSAT || isModel(outcome.model))) {
+                printOutcome(outcome, out);
+                return true;
+            }
+        }
+        if (options.renumber) {
+            auto numbering = make_shared<VariableRenumbering>(*this);
+            numbering->apply(*this);
+            renumbering = numbering;
+        }
+        if (options.symmetryClauses > 0) {
+            auto breaking = make_shared<SymmetryBreaking>(*this, options.symmetryClauses);
+            breaking->apply(*this);
+            symmetryBreaking = breaking;
+        }
+        if (options.decompose || options.engine != SolverEngine::CDCL) {
+            finish(options.decompose ? runDecomposed() : runEngine(), out);
+            return true;
+        }
+        suspendedRun = startCdcl();
+    }
+    if (!suspendedRun(conflicts, outcome)) {
+        return false;
+    }
+    suspendedRun = nullptr; // releases engine
+    finish(outcome, out);
+    return true;
+}
+
+void Solver::finish(Outcome outcome, std::ostream &out)
+{
+    auto breaking = symmetryBreaking;
+    if (symmetryBreaking) {
+        symmetryBreaking->restore(*this);
+        outcome.model = symmetryBreaking->restoreModel(outcome.model);
+        symmetryBreaking = nullptr;
+    }
+    if (renumbering) {
+        // cache keys and printed model refer to input numbering
+        renumbering->restore(*this);
+        outcome.model = renumbering->restoreModel(outcome.model);
+        renumbering = nullptr;
+    }
+    if (!options.cachePath.empty() && outcome.result != SolverResult::UNKNOWN) {
+        ResultCache cache(options.cachePath);
+        cache.store(*canonicalFormula, outcome.result, outcome.model);
+    }
+    printOutcome(outcome, out);
+    if (breaking) {
+        out << "c symmetry generators: " << breaking->getNbGenerators() << '\n'
+            << "c symmetry breaking clauses: " << breaking->getNbClauses() << '\n'
+            << "c symmetry detection time: " << breaking->getDetectionTime() << " s\n";
+    }
+}
+
+bool Solver::isModel(const std::vector<Variable> &model) const
+{
+    if (model.size() != static_cast<size_t>(nbVariables) + 1) {
+        return false;
+    }
+    for (unsigned i = 0; i < nbClauses; ++i) {
+        bool satisfied = false;
+        for (auto l : formula[i]) {
+            if (model[abs(l)] == (l > 0 ? Variable::POSITIVE : Variable::NEGATIVE)) {
+                satisfied = true;
+                break;
+            }
+        }
+        if (!satisfied) {
+            return false;
+        }
+    }
+    for (auto &constraint : cardinalityConstraints) {
+        unsigned count = 0;
+        for (auto l : constraint.literals) {
+            count += model[abs(l)] == (l > 0 ? Variable::POSITIVE : Variable::NEGATIVE);
+        }
+        if (count > constraint.bound) {
+            return false;
+        }
+    }
+    for (auto &constraint : xorConstraints) {
+        bool parity = false;
+        for (auto v : constraint.variables) {
+            parity ^= model[v] == Variable::POSITIVE;
+        }
+        if (parity != constraint.parity) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Solver::Outcome Solver::runEngine()
+{
+    switch (options.engine) {
+        case SolverEngine::RAW_DPLL: {
+            //out << "c !!!WARNING!!! This is raw DPLL. Expect very long runtime\n";
+            RawDpllImplementation impl(*this);
+            Outcome outcome;
+            outcome.result = impl.trySolve();
+            outcome.model = impl.getModel();
+            return outcome;
+        }
+        case SolverEngine::DPLL: {
+            DpllUpImplementation impl(*this);
+            return runImplementation(impl);
+        }
+        case SolverEngine::LOCAL_SEARCH: {
+            ProbSatImplementation impl(*this);
+            return runImplementation(impl);
+        }
+        case SolverEngine::HYBRID: {
+            HybridImplementation impl(*this);
+            return runImplementation(impl);
+        }
+        default: {
+            assert(options.engine == SolverEngine::CDCL);
+            Outcome outcome;
+            startCdcl()(0, outcome);
+            return outcome;
+        }
+    }
+}
+
+Solver::EngineRun Solver::startCdcl()
+{
+    // conflict vertex takes index nbVariables + 1
+    if (nbVariables < numeric_limits<int16_t>::max()) {
+        return startCdcl<int16_t>();
+    }
+    return startCdcl<int32_t>();
+}
+
+template<typename LiteralT>
+Solver::EngineRun Solver::startCdcl()
+{
+    auto &limits = options.limits;
+    if (limits.timeLimit == 0 && limits.conflictLimit == 0 && limits.propagationLimit == 0 &&
+        limits.memoryLimit == 0) {
+        // Without limits only cancellation leads to UNKNOWN, statistics are then omitted
+        return startCdcl<LiteralT, NoStatistics>();
+    }
+    return startCdcl<LiteralT, CountingStatistics>();
+}
+
+template<typename LiteralT, typename StatisticsPolicy>
+Solver::EngineRun Solver::startCdcl()
+{
+    if (options.proofPath.empty()) {
+        return resumable(make_shared<GraspTwlImplementation<LiteralT, StatisticsPolicy, NoProof>>(*this));
+    }
+    return resumable(make_shared<GraspTwlImplementation<LiteralT, StatisticsPolicy, DratProof>>(*this));
+}
+
+template<typename Implementation>
+Solver::EngineRun Solver::resumable(std::shared_ptr<Implementation> impl)
+{
+    return [impl](unsigned long long conflicts, Outcome &outcome) {
+        impl->setSliceLimit(conflicts);
+        outcome = runImplementation(*impl);
+        outcome.statisticsCounted = Implementation::countsStatistics;
+        return !impl->isSuspended();
+    };
+}
+
+void Solver::runOptimization(std::ostream &out)
+{
+    MaxSatImplementation optimization(*this, out);
+    auto outcome = runImplementation(optimization);
+    if (outcome.result == SolverResult::SAT) {
+        out << "OPTIMUM\n";
+        printModel(outcome.model, out);
+    } else if (outcome.result == SolverResult::UNKNOWN && !outcome.model.empty()) {
+        // feasible, optimality not proved
+        out << "SAT\n";
+        printModel(outcome.model, out);
+        if (outcome.exhaustedResource) {
+            out << "c budget exhausted: " << outcome.exhaustedResource << '\n';
+        }
+        out << "c cost bounds: " << optimization.getLowerBound() << ' ' << optimization.getCost() << '\n';
+    } else {
+        printOutcome(outcome, out);
+    }
+}
+
+void Solver::runTask(std::ostream &out)
+{
+    if (options.task == SolverTask::BACKBONE) {
+        BackboneComputation backbone(*this);
+        printOutcome(runImplementation(backbone), out);
+        return;
+    }
+    if (options.task == SolverTask::COUNT) {
+        ModelCounting counting(*this);
+        auto outcome = runImplementation(counting);
+        if (outcome.result == SolverResult::UNKNOWN) {
+            printOutcome(outcome, out);
+            return;
+        }
+        out << (outcome.result == SolverResult::SAT ? "SAT\n" : "UNSAT\n");
+        out << "c models: " << counting.getModelCount() << '\n';
+        return;
+    }
+    assert(options.task == SolverTask::ENUMERATE);
+    ModelEnumeration enumeration(*this, out);
+    auto outcome = runImplementation(enumeration);
+    if (enumeration.getModelCount() == 0) {
+        printOutcome(outcome, out);
+        return;
+    }
+    // models are already printed
+    if (outcome.result == SolverResult::UNKNOWN && outcome.exhaustedResource) {
+        out << "c budget exhausted: " << outcome.exhaustedResource << '\n';
+    }
+    out << "c models: " << enumeration.getModelCount() << '\n';
+}
+
+Solver::Outcome Solver::runDecomposed()
+{
+    auto start = chrono::steady_clock::now();
+    ComponentDecomposition decomposition(*this, options.simplify);
+    Outcome outcome;
+    if (decomposition.isUnsatisfiable()) {
+        outcome.result = SolverResult::UNSAT;
+        return outcome;
+    }
+    auto &components = decomposition.getComponents();
+    vector<Outcome> outcomes(components.size());
+    SolverOptions componentOptions = options;
+    componentOptions.decompose = false;
+    componentOptions.cancellation = options.cancellation.child(); // cancelled by first UNSAT component
+    atomic<size_t> nextComponent(0);
+    auto worker = [&]() {
+        for (size_t i; (i = nextComponent++) < components.size();) {
+            SolverOptions workerOptions = componentOptions;
+            if (options.limits.timeLimit > 0) {
+                // time limit applies to whole formula
+                workerOptions.limits.timeLimit -= chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                if (workerOptions.limits.timeLimit <= 0) {
+                    outcomes[i].result = SolverResult::UNKNOWN;
+                    outcomes[i].exhaustedResource = "time";
+                    continue;
+                }
+            }
+            Solver component(move(components[i].formula), components[i].variables.size(), workerOptions);
+            outcomes[i] = component.runEngine();
+            if (outcomes[i].result == SolverResult::UNSAT) {
+                componentOptions.cancellation.cancel();
+            }
+        }
+    };
+    vector<thread> workers;
+    for (unsigned i = 1; i < min<size_t>(options.threads, components.size()); ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto &t : workers) {
+        t.join();
+    }
+
+    outcome.result = SolverResult::SAT;
+    outcome.model = decomposition.getFixedVariables();
+    for (size_t i = 0; i < components.size(); ++i) {
+        outcome.statistics += outcomes[i].statistics;
+        outcome.statisticsCounted = outcome.statisticsCounted && outcomes[i].statisticsCounted;
+        if (outcomes[i].result == SolverResult::UNSAT) {
+            outcome.result = SolverResult::UNSAT;
+        } else if (outcomes[i].result == SolverResult::UNKNOWN && outcome.result == SolverResult::SAT) {
+            outcome.result = SolverResult::UNKNOWN;
+            outcome.exhaustedResource = outcomes[i].exhaustedResource;
+        } else if (outcomes[i].result == SolverResult::SAT) {
+            auto &variables = components[i].variables;
+            for (size_t j = 0; j < variables.size(); ++j) {
+                outcome.model[variables[j]] = outcomes[i].model[j + 1];
+            }
+        }
+    }
+    if (outcome.result == SolverResult::SAT) {
+        // variables left by simplification or occurring in no clause
+        for (Literal i = 1; i <= nbVariables; ++i) {
+            if (outcome.model[i] == Variable::UNKNOWN) {
+                outcome.model[i] = Variable::POSITIVE;
+            }
+        }
+    }
+    return outcome;
+}
+
+template<typename Implementation>
+Solver::Outcome Solver::runImplementation(Implementation &impl)
+{
+    Outcome outcome;
+    outcome.result = impl.trySolve();
+    outcome.model = impl.getModel();
+    outcome.statistics = impl.getStatistics();
+    outcome.exhaustedResource = impl.getExhaustedResource();
+    return outcome;
+}
+
+void Solver::printOutcome(const Outcome &outcome, std::ostream &out)
+{
+    switch (outcome.result) {
         case SolverResult::SAT:
             out << "SAT\n"; //"s SATISFIABLE\n";
             break;
@@ -81,22 +617,32 @@ void Solver::solve(std::ostream &out)
             out << "UNSAT\n"; //"s UNSATISFIABLE\n";
             break;
         default:
-            assert(result == SolverResult::UNKNOWN);
+            assert(outcome.result == SolverResult::UNKNOWN);
             out << "s UNKNOWN\n";
-            break;
-    }
-    if (result == SolverResult::SAT) {
-        //out << 'v';
-        auto &model = impl.getModel();
-        for (int i = 1; i < model.size(); ++i) {
-            if (model[i] == Variable::UNKNOWN) {
-                continue;
+            if (outcome.exhaustedResource) {
+                out << "c budget exhausted: " << outcome.exhaustedResource << '\n';
             }
-            if (model[i] == Variable::NEGATIVE) {
-                out << '-';
+            if (outcome.statisticsCounted) {
+                outcome.statistics.print(out);
             }
-            out << i << ' ';
+            break;
+    }
+    if (outcome.result == SolverResult::SAT) {
+        printModel(outcome.model, out);
+    }
+}
+
+void Solver::printModel(const std::vector<Variable> &model, std::ostream &out)
+{
+    //out << 'v';
+    for (int i = 1; i < model.size(); ++i) {
+        if (model[i] == Variable::UNKNOWN) {
+            continue;
+        }
+        if (model[i] == Variable::NEGATIVE) {
+            out << '-';
         }
-        out << "0\n";
+        out << i << ' ';
     }
+    out << "0\n";
 }
@@ -1,18 +1,35 @@
 #ifndef FREAKSATSOLVER_SOLVER_HXX
 #define FREAKSATSOLVER_SOLVER_HXX
 
+#include <cstdint>
 #include <iosfwd>
 #include <vector>
+#include <functional>
+#include <memory>
 #include "SolverResult.hxx"
 #include "Variable.hxx"
+#include "SolverOptions.hxx"
+#include "Statistics.hxx"
+#include "ExtendedConstraints.hxx"
+
+class BinaryCnf;
+
+class VariableRenumbering;
+
+class SymmetryBreaking;
+
+struct CanonicalFormula;
 
 /**
- * Reads CFN formula from input (in DIMACS format), performs computation, prints result to output.
+ * Reads CFN formula from input (in DIMACS format), performs computation, prints result to output. Besides clauses
+ * input may contain XOR ("x") and cardinality ("k") lines, those are supported by CDCL engine only. Comment lines
+ * "c p show VARIABLES 0" before header give projection of model enumeration. Instance with "p wcnf" header is
+ * weighted, its model of minimal cost is searched.
  */
 class Solver
 {
     typedef int Literal;
-    // Strategy/State pattern can be applied at construction time to choose compact representation of literals
+    // Parsed representation, CDCL engine copies clauses into compact literal type chosen in runEngine
     // Requirements on literals: able to represent negative, 0, positive integers in range [-nbVariables; nbVariables]
 
     typedef std::vector<Literal> Clause;
@@ -20,26 +37,188 @@ class Solver
 
     Formula formula;
     Literal nbVariables;
-    unsigned nbClauses;
+    unsigned nbClauses; // clauses only, header count includes extended constraints
+    std::vector<CardinalityConstraint> cardinalityConstraints;
+    std::vector<XorConstraint> xorConstraints;
+    bool weighted = false;              // "p wcnf" instance, @c formula holds its hard clauses
+    std::vector<SoftClause> softClauses;
+    SolverOptions options;
+    std::shared_ptr<const BinaryCnf> snapshot; // source of clauses while formula is not loaded from it, null otherwise
+    std::vector<Literal> projection; // variables of "c p show" lines, empty if instance has none
 
     // Executor is external
     friend class RawDpllImplementation;
 
     friend class DpllUpImplementation; // TODO inject here
 
+    template<typename, typename, typename, typename>
     friend class GraspTwlImplementation;
 
-    friend class TwoWatchedLiterals;
+    friend class ProbSatImplementation;
+
+    friend class HybridImplementation;
+
+    friend class BackboneComputation;
+
+    friend class ModelEnumeration;
+
+    friend class ModelCounting;
+
+    friend class MaxSatImplementation;
+
+    friend class ComponentDecomposition;
+
+    friend class BinaryCnf;
 
-    friend class ChaffTwoWatchedLiterals;
+    friend class ResultCache;
+
+    friend class BatchScheduler;
+
+    friend class VariableRenumbering;
+
+    friend class SymmetryBreaking;
 
 public:
-    Solver(std::istream &in);
+    Solver(std::istream &in, const SolverOptions &options = SolverOptions());
+
+    /**
+     * Loads instance from precompiled snapshot, no DIMACS parsing takes place. CDCL engine copies clauses straight
+     * from snapshot, so @c formula is filled only for other engines and preprocessing.
+     */
+    Solver(std::shared_ptr<const BinaryCnf> cnf, const SolverOptions &options = SolverOptions());
+
+    /**
+     * Writes original clauses as binary snapshot
+     */
+    void writeBinary(std::ostream &out) const;
 
     void solve(std::ostream &out);
 
+    /**
+     * Runs up to @c conflicts conflicts of CDCL search (0 - no limit). Once solve finishes prints result and returns
+     * true, otherwise search is suspended and next call resumes it. Other engines and decomposition run to completion
+     * in first call.
+     */
+    bool solveSlice(std::ostream &out, unsigned long long conflicts);
+
 private:
+    /**
+     * Creates instance from already parsed @c formula
+     */
+    Solver(Formula formula, Literal nbVariables, const SolverOptions &options);
+
+    /**
+     * Parses literals of line until terminating 0
+     */
+    std::vector<Literal> parseConstraintLiterals(std::istream &parser, const std::string &line) const;
+
+    void parseXorConstraint(const std::string &line);
+
+    void parseCardinalityConstraint(const std::string &line);
+
+    void parseProjection(const std::string &line);
+
+    /**
+     * Parses WCNF clause line, clauses with weight @c top or higher are hard
+     */
+    void parseWeightedClause(const std::string &line, unsigned long long top);
+
+    /**
+     * Copies clauses of snapshot into @c formula and releases snapshot
+     */
+    void loadSnapshot();
+
+    /**
+     * Throws @c BinaryCnfFormatException if snapshot clause contains literal out of range
+     */
+    void checkSnapshotClause(const std::int32_t *begin, const std::int32_t *end) const;
+
+    /**
+     * Result of single engine run
+     */
+    struct Outcome
+    {
+        SolverResult result;
+        std::vector<Variable> model;
+        Statistics statistics;
+        bool statisticsCounted = true; // false if engine ran with NoStatistics
+        const char *exhaustedResource = nullptr;
+    };
+
+    /**
+     * Engine run which may be suspended between restarts. Call with conflict limit of slice (0 - no limit) returns
+     * true and fills outcome once run finishes.
+     */
+    typedef std::function<bool(unsigned long long, Outcome &)> EngineRun;
+
+    EngineRun suspendedRun; // CDCL run of solveSlice between slices
+
+    std::shared_ptr<const VariableRenumbering> renumbering; // formula renumbered while solving, null if not
+
+    std::shared_ptr<const SymmetryBreaking> symmetryBreaking; // breaking clauses appended while solving, null if not
+
+    std::shared_ptr<const CanonicalFormula> canonicalFormula; // result cache key computed by lookup, reused by store
+
+    /**
+     * Removes symmetry-breaking clauses and restores original numbering (if renumbered), stores result in cache (if
+     * enabled) and prints it with symmetry report
+     */
+    void finish(Outcome outcome, std::ostream &out);
+
+    /**
+     * Runs engine selected in options
+     */
+    Outcome runEngine();
+
+    /**
+     * Creates CDCL engine with literal type fitting instance
+     */
+    EngineRun startCdcl();
+
+    /**
+     * Creates CDCL engine with given literal type, picks statistics and proof policies from options
+     */
+    template<typename LiteralT>
+    EngineRun startCdcl();
+
+    template<typename LiteralT, typename StatisticsPolicy>
+    EngineRun startCdcl();
+
+    template<typename Implementation>
+    static EngineRun resumable(std::shared_ptr<Implementation> impl);
+
+    /**
+     * Computes backbone, enumerates or counts models, runs to completion
+     */
+    void runTask(std::ostream &out);
+
+    /**
+     * Searches model of weighted instance with minimal cost, prints improving costs as they are found
+     */
+    void runOptimization(std::ostream &out);
+
+    /**
+     * Solves variable-disjoint components of formula on thread pool, stops at first UNSAT component
+     */
+    Outcome runDecomposed();
+
+    /**
+     * Collects result, model and statistics of engine @c impl
+     */
+    template<typename Implementation>
+    static Outcome runImplementation(Implementation &impl);
+
+    /**
+     * Checks whether @c model satisfies all original clauses and extended constraints
+     */
+    bool isModel(const std::vector<Variable> &model) const;
+
+    static void printOutcome(const Outcome &outcome, std::ostream &out);
 
+    /**
+     * Prints assigned literals of @c model terminated by 0, UNKNOWN variables are skipped
+     */
+    static void printModel(const std::vector<Variable> &model, std::ostream &out);
 };
 
 
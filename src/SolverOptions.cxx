@@ -0,0 +1,159 @@
+#include <ostream>
+#include <stdexcept>
+#include "SolverOptions.hxx"
+#include "OptionParsing.hxx"
+
+using namespace std;
+
+static SolverEngine parseEngine(const string &name)
+{
+    if (name == "cdcl") {
+        return SolverEngine::CDCL;
+    } else if (name == "dpll") {
+        return SolverEngine::DPLL;
+    } else if (name == "raw") {
+        return SolverEngine::RAW_DPLL;
+    } else if (name == "local") {
+        return SolverEngine::LOCAL_SEARCH;
+    } else if (name == "hybrid") {
+        return SolverEngine::HYBRID;
+    }
+    throw invalid_argument("Unknown engine: >" + name + "<");
+}
+
+static SearchMode parseSearchMode(const string &name)
+{
+    if (name == "alternate") {
+        return SearchMode::ALTERNATE;
+    } else if (name == "focused") {
+        return SearchMode::FOCUSED;
+    } else if (name == "stable") {
+        return SearchMode::STABLE;
+    }
+    throw invalid_argument("Unknown search mode: >" + name + "<");
+}
+
+static MaxSatAlgorithm parseMaxSatAlgorithm(const string &name)
+{
+    if (name == "oll") {
+        return MaxSatAlgorithm::CORE_GUIDED;
+    } else if (name == "linear") {
+        return MaxSatAlgorithm::LINEAR;
+    }
+    throw invalid_argument("Unknown MaxSAT algorithm: >" + name + "<");
+}
+
+bool SolverOptions::parse(const std::string &argument)
+{
+    size_t megabytes;
+    string engineName;
+    string modeName;
+    string algorithmName;
+    bool backbone = false;
+    bool count = false;
+    if (parseOption(argument, "time-limit", limits.timeLimit) ||
+        parseOption(argument, "conflict-limit", limits.conflictLimit) ||
+        parseOption(argument, "propagation-limit", limits.propagationLimit) ||
+        parseFlag(argument, "decompose", decompose) ||
+        parseFlag(argument, "simplify", simplify) ||
+        parseOption(argument, "threads", threads) ||
+        parseOption(argument, "trail-saving", trailSaving) ||
+        parseOption(argument, "chrono", chronoThreshold) ||
+        parseOption(argument, "rephase", rephase) ||
+        parseFlag(argument, "renumber", renumber) ||
+        parseOption(argument, "symmetry", symmetryClauses) ||
+        parseOption(argument, "cache", cachePath) ||
+        parseOption(argument, "proof", proofPath) ||
+        parseOption(argument, "checkpoint", checkpointPath) ||
+        parseOption(argument, "checkpoint-interval", checkpointInterval)) {
+        return true;
+    } else if (parseOption(argument, "engine", engineName)) {
+        engine = parseEngine(engineName);
+        return true;
+    } else if (parseOption(argument, "mode", modeName)) {
+        searchMode = parseSearchMode(modeName);
+        return true;
+    } else if (parseOption(argument, "maxsat", algorithmName)) {
+        maxSatAlgorithm = parseMaxSatAlgorithm(algorithmName);
+        return true;
+    } else if (parseFlag(argument, "backbone", backbone)) {
+        task = SolverTask::BACKBONE;
+        return true;
+    } else if (parseOption(argument, "enumerate", maxModels)) {
+        task = SolverTask::ENUMERATE;
+        return true;
+    } else if (parseFlag(argument, "count", count)) {
+        task = SolverTask::COUNT;
+        return true;
+    } else if (parseOption(argument, "count-cache", megabytes)) {
+        countCacheSize = megabytes * 1024 * 1024;
+        return true;
+    } else if (parseOption(argument, "memory-limit", megabytes)) {
+        limits.memoryLimit = megabytes * 1024 * 1024;
+        return true;
+    }
+    return false;
+}
+
+void SolverOptions::validate() const
+{
+    if (!proofPath.empty() && (engine != SolverEngine::CDCL || decompose)) {
+        throw invalid_argument("Proof is produced only by CDCL engine without decomposition");
+    }
+    if (!checkpointPath.empty() && (engine != SolverEngine::CDCL || decompose || !proofPath.empty())) {
+        // resumed run would miss learned clauses in proof
+        throw invalid_argument("Checkpoints are supported only by CDCL engine without decomposition and proof");
+    }
+    if (renumber && !proofPath.empty()) {
+        // proof would refer to renumbered variables
+        throw invalid_argument("Proof cannot be combined with renumbering");
+    }
+    if (symmetryClauses > 0 && (!proofPath.empty() || task != SolverTask::SOLVE)) {
+        // breaking clauses are not implied by formula and remove models
+        throw invalid_argument("Symmetry breaking cannot be combined with proof, backbone, enumeration and counting");
+    }
+    if (task != SolverTask::SOLVE && (engine != SolverEngine::CDCL || decompose || renumber || !cachePath.empty() ||
+                                      !proofPath.empty() || !checkpointPath.empty())) {
+        // blocking clauses are not implied by formula, cache holds single model
+        throw invalid_argument("Backbone, enumeration and counting require cdcl engine without decomposition, "
+                               "renumbering, cache, proof and checkpoints");
+    }
+}
+
+void SolverOptions::printUsage(std::ostream &out)
+{
+    out << "  --engine=ENGINE             cdcl (default), dpll, raw, local (ProbSAT, never proves UNSAT)\n"
+        << "                              or hybrid (ProbSAT and CDCL exchanging phases)\n"
+        << "  --decompose                 solve variable-disjoint components independently\n"
+        << "  --simplify                  with --decompose: unit propagation at level 0 before decomposition\n"
+        << "  --threads=N                 number of workers solving components (default: all cores)\n"
+        << "  --trail-saving=0|1          cdcl: replay propagations undone by backjump (default: 0)\n"
+        << "  --chrono=LEVELS             cdcl: backtrack single level instead of backjumping over more than\n"
+        << "                              LEVELS levels, 0 disables (default: 0)\n"
+        << "  --mode=MODE                 cdcl: focused (VMTF, frequent restarts), stable (VSIDS, target phases,\n"
+        << "                              rare restarts) or alternate between them (default)\n"
+        << "  --rephase=0|1               cdcl: periodically reset saved phases to original, inverted, best,\n"
+        << "                              random or local search phases (default: 1)\n"
+        << "  --backbone                  print literals true in every model instead of single model\n"
+        << "  --enumerate=N               print up to N models (0: all) as they are found, projected onto\n"
+        << "                              variables of \"c p show ... 0\" lines if instance has them\n"
+        << "  --count                     print number of models (component caching DPLL, components of formula\n"
+        << "                              counted by --threads workers)\n"
+        << "  --count-cache=MEGABYTES     memory of component cache of --count (default: 512)\n"
+        << "  --maxsat=ALGORITHM          weighted (p wcnf) instances: oll (core-guided, stratified, default) or\n"
+        << "                              linear (SAT-UNSAT search), improving costs are printed as \"o COST\"\n"
+        << "  --renumber                  renumber variables and reorder clauses so that interacting variables\n"
+        << "                              are close in memory, model is printed in original numbering\n"
+        << "  --symmetry=CLAUSES          detect symmetries of clauses and add up to CLAUSES lex-leader\n"
+        << "                              symmetry-breaking clauses, 0 disables (default: 0)\n"
+        << "  --time-limit=SECONDS        stop with UNKNOWN after given wall-clock time\n"
+        << "  --conflict-limit=N          stop with UNKNOWN after N conflicts\n"
+        << "  --propagation-limit=N       stop with UNKNOWN after N propagated literals\n"
+        << "  --memory-limit=MEGABYTES    stop with UNKNOWN when solve grows memory beyond limit\n"
+        << "  --cache=PATH                reuse results of formulas solved before (PATH.idx, PATH.dat)\n"
+        << "  --proof=PATH                write DRAT proof of cdcl engine (PATH.i for many instances)\n"
+        << "  --checkpoint=PATH           cdcl: periodically save learned clauses, activities and phases to PATH\n"
+        << "                              (PATH.i for many instances), resume from it if it exists\n"
+        << "  --checkpoint-interval=SECONDS\n"
+        << "                              seconds between checkpoints (default: 300)\n";
+}
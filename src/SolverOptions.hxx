@@ -0,0 +1,83 @@
+#ifndef FREAKSATSOLVER_SOLVEROPTIONS_HXX
+#define FREAKSATSOLVER_SOLVEROPTIONS_HXX
+
+#include <iosfwd>
+#include <string>
+#include "Budget.hxx"
+
+enum class SolverEngine
+{
+    CDCL, DPLL, RAW_DPLL, LOCAL_SEARCH, HYBRID,
+};
+
+/**
+ * CDCL search modes. Focused mode decides by VMTF queue and restarts often, stable mode decides by VSIDS with target
+ * phases and restarts rarely.
+ */
+enum class SearchMode
+{
+    ALTERNATE, FOCUSED, STABLE,
+};
+
+/**
+ * Optimization of weighted instances. Core-guided OLL raises lower bound by unsatisfiable cores and switches to linear
+ * search when its encodings outgrow their budget, linear search lowers upper bound by models.
+ */
+enum class MaxSatAlgorithm
+{
+    CORE_GUIDED, LINEAR,
+};
+
+/**
+ * What solver computes. Backbone and enumeration run single CDCL engine incrementally, learned clauses are kept
+ * between its calls. Counting runs its own DPLL engine with component caching.
+ */
+enum class SolverTask
+{
+    SOLVE,     // satisfiability and model
+    BACKBONE,  // literals true in every model
+    ENUMERATE, // models streamed as they are found, projected onto "c p show" variables if given
+    COUNT,     // exact number of models
+};
+
+/**
+ * Run-time configuration of @c Solver
+ */
+struct SolverOptions
+{
+    SolverEngine engine = SolverEngine::CDCL;
+    SolverTask task = SolverTask::SOLVE;
+    unsigned long long maxModels = 0; // models printed by enumeration, 0 - all
+    std::size_t countCacheSize = 512 * 1024 * 1024; // bytes of component cache of counting, split among workers
+    MaxSatAlgorithm maxSatAlgorithm = MaxSatAlgorithm::CORE_GUIDED;
+    bool decompose = false;          // solve variable-disjoint components independently
+    bool simplify = false;           // unit propagation at level 0 before decomposition
+    unsigned threads = 1;            // workers solving components
+    bool trailSaving = false;        // CDCL replays propagations undone by backjump
+    unsigned chronoThreshold = 0;    // CDCL backtracks single level instead of longer backjump, 0 disables
+    SearchMode searchMode = SearchMode::ALTERNATE;
+    bool rephase = true;             // CDCL periodically resets saved phases
+    bool renumber = false;           // variables renumbered by breadth-first order of interaction graph at load time
+    std::size_t symmetryClauses = 0; // budget of lex-leader symmetry-breaking clauses, 0 disables detection
+    ResourceLimits limits;
+    std::string cachePath;           // persistent result cache, disabled if empty
+    std::string proofPath;           // DRAT proof of CDCL run, disabled if empty
+    std::string checkpointPath;      // CDCL search state saved periodically and resumed, disabled if empty
+    double checkpointInterval = 300; // seconds between checkpoints
+    CancellationToken cancellation;
+
+    /**
+     * Applies single command line argument. Returns false if @c argument is not a solver option, throws if its value
+     * is malformed.
+     */
+    bool parse(const std::string &argument);
+
+    /**
+     * Throws if options cannot be combined
+     */
+    void validate() const;
+
+    static void printUsage(std::ostream &out);
+};
+
+#endif //FREAKSATSOLVER_SOLVEROPTIONS_HXX
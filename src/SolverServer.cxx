@@ -0,0 +1,284 @@
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <system_error>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <malloc.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "SolverServer.hxx"
+#include "Solver.hxx"
+#include "BinaryCnf.hxx"
+
+using namespace std;
+
+constexpr size_t SolverServer::maxRequestSize;
+
+namespace
+{
+/**
+ * Reads from memory without copying it
+ */
+class MemoryReadBuffer : public streambuf
+{
+public:
+    MemoryReadBuffer(char *begin, char *end)
+    {
+        setg(begin, begin, end);
+    }
+};
+
+/**
+ * Appends everything written to string, keeping its capacity
+ */
+class StringWriteBuffer : public streambuf
+{
+    string &target;
+
+public:
+    explicit StringWriteBuffer(string &target) : target(target)
+    { }
+
+protected:
+    int_type overflow(int_type c) override
+    {
+        if (c != traits_type::eof()) {
+            target.push_back(traits_type::to_char_type(c));
+        }
+        return c;
+    }
+
+    streamsize xsputn(const char *s, streamsize n) override
+    {
+        target.append(s, n);
+        return n;
+    }
+};
+}
+
+SolverServer::SolverServer(const std::string &socketPath, unsigned nbWorkers, const SolverOptions &defaults)
+        : socketPath(socketPath), nbWorkers(nbWorkers), defaults(defaults)
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw invalid_argument("Socket path too long: >" + socketPath + "<");
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        throw system_error(errno, system_category(), "Unable to create socket");
+    }
+    unlink(socketPath.c_str()); // stale socket of previous instance
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0) {
+        auto error = errno;
+        close(listener);
+        throw system_error(error, system_category(), "Unable to listen on >" + socketPath + "<");
+    }
+}
+
+SolverServer::~SolverServer()
+{
+    close(listener);
+    unlink(socketPath.c_str());
+}
+
+void SolverServer::run()
+{
+    // engines free their clause database and watches after every request, glibc would return them to the kernel
+    // (trim, munmap of large blocks) only to fault them in again for the next request
+    mallopt(M_TRIM_THRESHOLD, numeric_limits<int>::max());
+    mallopt(M_MMAP_THRESHOLD, 32 << 20); // largest value glibc accepts on 64-bit
+
+    sigset_t signals, previousSignals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &signals, &previousSignals); // inherited by all threads started below
+    thread signalHandler(&SolverServer::handleSignals, this, cref(signals));
+    vector<thread> workers;
+    for (unsigned i = 0; i < nbWorkers; ++i) {
+        workers.emplace_back(&SolverServer::work, this);
+    }
+    for (;;) {
+        int connection = accept(listener, nullptr, nullptr);
+        lock_guard<mutex> lock(queueMutex);
+        if (stopping) {
+            if (connection >= 0) {
+                close(connection);
+            }
+            break;
+        }
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            stopping = true;
+            break;
+        }
+        pendingConnections.push(connection);
+        queueChanged.notify_one();
+    }
+    queueChanged.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    pthread_kill(signalHandler.native_handle(), SIGTERM); // wakes up sigwait if server stopped otherwise
+    signalHandler.join();
+    pthread_sigmask(SIG_SETMASK, &previousSignals, nullptr);
+}
+
+void SolverServer::stop()
+{
+    lock_guard<mutex> lock(queueMutex);
+    stopping = true;
+    defaults.cancellation.cancel();
+    shutdown(listener, SHUT_RDWR); // wakes up accept
+    queueChanged.notify_all();
+}
+
+void SolverServer::handleSignals(const sigset_t &signals)
+{
+    int signal;
+    while (sigwait(&signals, &signal) != 0) { }
+    stop();
+}
+
+void SolverServer::work()
+{
+    string request, response;
+    for (;;) {
+        int connection;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueChanged.wait(lock, [this]() { return stopping || !pendingConnections.empty(); });
+            if (pendingConnections.empty()) {
+                return;
+            }
+            connection = pendingConnections.front();
+            pendingConnections.pop();
+        }
+        serve(connection, request, response);
+        close(connection);
+    }
+}
+
+void SolverServer::serve(int connection, std::string &request, std::string &response)
+{
+    request.clear();
+    response.clear();
+    try {
+        if (!readAll(connection, request)) {
+            return;
+        }
+        process(request, response);
+    } catch (const exception &e) {
+        response.clear();
+        response += "s ERROR\nc ";
+        response += e.what();
+        response += '\n';
+    }
+    try {
+        writeAll(connection, response);
+    } catch (const system_error &) {
+        // client went away, nothing to do
+    }
+}
+
+void SolverServer::process(std::string &request, std::string &response)
+{
+    auto headerEnd = request.find('\n');
+    if (headerEnd == string::npos) {
+        throw invalid_argument("Missing request header");
+    }
+    istringstream header(request.substr(0, headerEnd));
+    string format, argument;
+    header >> format;
+    SolverOptions options = defaults;
+    options.cancellation = defaults.cancellation.child();
+    while (header >> argument) {
+        if (!isRequestOption(argument)) {
+            throw invalid_argument("Option not allowed in request: >" + argument + "<");
+        }
+        if (!options.parse(argument)) {
+            throw invalid_argument("Unknown option: >" + argument + "<");
+        }
+    }
+    options.validate();
+    StringWriteBuffer outputBuffer(response);
+    ostream out(&outputBuffer);
+    if (format == "dimacs") {
+        MemoryReadBuffer inputBuffer(&request[headerEnd + 1], &request[0] + request.size());
+        istream in(&inputBuffer);
+        Solver solver(in, options);
+        solver.solve(out);
+    } else if (format == "binary") {
+        request.erase(0, headerEnd + 1); // snapshot needs alignment of buffer start
+        // request comes from other process, unlike snapshot files it is always verified
+        auto cnf = make_shared<const BinaryCnf>(request.data(), request.size(), true);
+        Solver solver(cnf, options);
+        solver.solve(out);
+    } else {
+        throw invalid_argument("Unknown instance format: >" + format + "<");
+    }
+}
+
+bool SolverServer::readAll(int fd, std::string &buffer)
+{
+    constexpr size_t chunk = 1 << 16;
+    for (;;) {
+        auto size = buffer.size();
+        if (size > maxRequestSize) {
+            throw length_error("Request exceeds " + to_string(maxRequestSize) + " bytes");
+        }
+        buffer.resize(size + chunk);
+        auto received = read(fd, &buffer[size], chunk);
+        if (received < 0 && errno == EINTR) {
+            buffer.resize(size);
+            continue;
+        }
+        if (received < 0) {
+            return false;
+        }
+        buffer.resize(size + received);
+        if (received == 0) {
+            return true;
+        }
+    }
+}
+
+void SolverServer::writeAll(int fd, const std::string &buffer)
+{
+    for (size_t written = 0; written < buffer.size();) {
+        auto sent = send(fd, buffer.data() + written, buffer.size() - written, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw system_error(errno, system_category(), "Unable to send response");
+        }
+        written += sent;
+    }
+}
+
+bool SolverServer::isRequestOption(const std::string &argument)
+{
+    static const unordered_set<string> allowed = {"engine", "mode", "rephase", "trail-saving", "chrono", "renumber",
+                                                  "time-limit", "conflict-limit", "propagation-limit",
+                                                  "memory-limit"};
+    if (argument.compare(0, 2, "--") != 0) {
+        return false;
+    }
+    return allowed.count(argument.substr(2, argument.find('=') - 2)) > 0;
+}
@@ -0,0 +1,86 @@
+#ifndef FREAKSATSOLVER_SOLVERSERVER_HXX
+#define FREAKSATSOLVER_SOLVERSERVER_HXX
+
+#include <cstddef>
+#include <string>
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+#include <csignal>
+#include "SolverOptions.hxx"
+
+/**
+ * Long-lived solver daemon listening on Unix domain socket. Every connection carries single request: header line
+ * "dimacs [options...]" or "binary [options...]" followed by instance (DIMACS text or binary snapshot) up to the point
+ * where client shuts down writing, at most @c maxRequestSize bytes. Options are command line options which affect only
+ * the search (engine, mode, budgets...) overriding server defaults; options touching files or threads of the server
+ * (proof, cache, checkpoint, threads, decomposition) are rejected. Response is written in command line output format,
+ * then connection is closed.
+ * Connections are queued to fixed pool of workers. Each worker keeps its request and response buffers between
+ * requests, and freed heap of solved instances is kept by allocator for the next one. SIGTERM and SIGINT stop server.
+ */
+class SolverServer
+{
+public:
+    static constexpr std::size_t maxRequestSize = std::size_t(1) << 30;
+
+private:
+    std::string socketPath;
+    unsigned nbWorkers;
+    SolverOptions defaults;
+    int listener = -1;
+
+    std::mutex queueMutex;
+    std::condition_variable queueChanged;
+    std::queue<int> pendingConnections;
+    bool stopping = false;
+
+public:
+    SolverServer(const std::string &socketPath, unsigned nbWorkers, const SolverOptions &defaults);
+
+    SolverServer(const SolverServer &) = delete;
+
+    SolverServer &operator=(const SolverServer &) = delete;
+
+    ~SolverServer();
+
+    /**
+     * Accepts connections until @c stop is called
+     */
+    void run();
+
+    /**
+     * Stops accepting connections and cancels running solves. Queued requests are answered with UNKNOWN.
+     */
+    void stop();
+
+private:
+    void work();
+
+    /**
+     * Calls @c stop on first SIGTERM or SIGINT, which are blocked in all other threads of @c run
+     */
+    void handleSignals(const sigset_t &signals);
+
+    /**
+     * Handles single request, @c request and @c response are worker buffers reused between requests
+     */
+    void serve(int connection, std::string &request, std::string &response);
+
+    void process(std::string &request, std::string &response);
+
+    /**
+     * Reads until end of stream. Returns false on read error, throws if more than @c maxRequestSize bytes arrive.
+     */
+    static bool readAll(int fd, std::string &buffer);
+
+    /**
+     * Returns true if option @c argument may be set by request header
+     */
+    static bool isRequestOption(const std::string &argument);
+
+    static void writeAll(int fd, const std::string &buffer);
+};
+
+
+#endif //FREAKSATSOLVER_SOLVERSERVER_HXX
@@ -0,0 +1,25 @@
+#include <ostream>
+#include "Statistics.hxx"
+
+using namespace std;
+
+Statistics &Statistics::operator+=(const Statistics &other)
+{
+    decisions += other.decisions;
+    conflicts += other.conflicts;
+    propagations += other.propagations;
+    restarts += other.restarts;
+    learnedClauses += other.learnedClauses;
+    flips += other.flips;
+    return *this;
+}
+
+void Statistics::print(std::ostream &out) const
+{
+    out << "c decisions: " << decisions << '\n';
+    out << "c conflicts: " << conflicts << '\n';
+    out << "c propagations: " << propagations << '\n';
+    out << "c restarts: " << restarts << '\n';
+    out << "c learned clauses: " << learnedClauses << '\n';
+    out << "c flips: " << flips << '\n';
+}
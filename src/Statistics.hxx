@@ -0,0 +1,27 @@
+#ifndef FREAKSATSOLVER_STATISTICS_HXX
+#define FREAKSATSOLVER_STATISTICS_HXX
+
+#include <iosfwd>
+
+/**
+ * Search counters collected by engine. Also used to check resource budgets.
+ */
+struct Statistics
+{
+    unsigned long long decisions = 0;
+    unsigned long long conflicts = 0;
+    unsigned long long propagations = 0;
+    unsigned long long restarts = 0;
+    unsigned long long learnedClauses = 0;
+    unsigned long long flips = 0;          // local search
+
+    Statistics &operator+=(const Statistics &other);
+
+    /**
+     * Prints counters as DIMACS comment lines
+     */
+    void print(std::ostream &out) const;
+};
+
+
+#endif //FREAKSATSOLVER_STATISTICS_HXX
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include "AutomorphismSearch.hxx"
+#include "SymmetryBreaking.hxx"
+
+using namespace std;
+
+constexpr unsigned long long SymmetryBreaking::searchWork;
+
+SymmetryBreaking::SymmetryBreaking(const Solver &satInstance, std::size_t maxClauses)
+        : nbVariables(satInstance.nbVariables), nbClauses(satInstance.nbClauses)
+{
+    auto start = chrono::steady_clock::now();
+    // literal nodes 2k (positive) and 2k + 1 (negative) for k-th used variable, then clause nodes
+    vector<unsigned> node(nbVariables + 1, 0);
+    vector<Literal> used;
+    for (unsigned i = 0; i < nbClauses; ++i) {
+        for (auto l : satInstance.formula[i]) {
+            if (node[abs(l)] == 0) {
+                used.push_back(abs(l));
+                node[abs(l)] = used.size(); // shifted by one, 0 marks unused variable
+            }
+        }
+    }
+    auto literalNode = [&node](Literal l) { return 2 * (node[abs(l)] - 1) + (l < 0); };
+    auto nbLiteralNodes = 2 * used.size();
+    vector<vector<unsigned>> adjacency(nbLiteralNodes + nbClauses);
+    vector<unsigned> colors(adjacency.size(), 1);
+    for (unsigned k = 0; k < used.size(); ++k) {
+        adjacency[2 * k].push_back(2 * k + 1);
+        adjacency[2 * k + 1].push_back(2 * k);
+        colors[2 * k] = colors[2 * k + 1] = 0;
+    }
+    for (unsigned i = 0; i < nbClauses; ++i) {
+        auto clauseNode = nbLiteralNodes + i;
+        for (auto l : satInstance.formula[i]) {
+            adjacency[clauseNode].push_back(literalNode(l));
+            adjacency[literalNode(l)].push_back(clauseNode);
+        }
+    }
+
+    AutomorphismSearch search(move(adjacency), colors, searchWork);
+    // literal nodes are joined only with their complement, so each generator maps complementary literals together
+    auto literalOf = [&used](unsigned vertex) {
+        auto v = used[vertex / 2];
+        return vertex % 2 ? -v : v;
+    };
+    bool budgetLeft = maxClauses > 0;
+    for (auto &generator : search.getGenerators()) {
+        vector<Literal> moved;
+        vector<Literal> image(nbVariables + 1);
+        for (unsigned k = 0; k < used.size(); ++k) {
+            if (generator[2 * k] != 2 * k) {
+                moved.push_back(used[k]);
+                image[used[k]] = literalOf(generator[2 * k]);
+            }
+        }
+        if (moved.empty()) {
+            continue; // permutes duplicate clauses only
+        }
+        nbGenerators += 1;
+        sort(moved.begin(), moved.end());
+        if (budgetLeft) {
+            budgetLeft = addLexLeader(moved, image, maxClauses);
+        }
+    }
+    detectionTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+bool SymmetryBreaking::addLexLeader(const std::vector<Literal> &moved, const std::vector<Literal> &image,
+                                    std::size_t maxClauses)
+{
+    // equal - auxiliary variable implied by equality of prefix, 0 before first position
+    Literal equal = 0;
+    for (size_t i = 0; i < moved.size(); ++i) {
+        auto x = moved[i];
+        auto y = image[x];
+        auto add = [this, equal](Clause clause) {
+            if (equal != 0) {
+                clause.push_back(-equal);
+            }
+            clauses.push_back(move(clause));
+        };
+        add({-x, y});
+        if (clauses.size() >= maxClauses) {
+            return false;
+        }
+        if (y == -x || i + 1 == moved.size()) {
+            return true; // with y = -x clause forces x false, which makes order strict
+        }
+        if (clauses.size() + 3 > maxClauses) {
+            return false; // equality without constraint of next position is useless
+        }
+        // x = y under equal prefix unless x is false and y true, in which case order is strict
+        auto next = nbVariables + ++nbAuxiliaryVariables;
+        add({-x, next});
+        add({y, next});
+        equal = next;
+    }
+    return true;
+}
+
+void SymmetryBreaking::apply(Solver &satInstance) const
+{
+    satInstance.formula.insert(satInstance.formula.begin() + nbClauses, clauses.begin(), clauses.end());
+    satInstance.nbClauses += clauses.size();
+    satInstance.nbVariables += nbAuxiliaryVariables;
+}
+
+void SymmetryBreaking::restore(Solver &satInstance) const
+{
+    satInstance.formula.erase(satInstance.formula.begin() + nbClauses,
+                              satInstance.formula.begin() + nbClauses + clauses.size());
+    satInstance.nbClauses = nbClauses;
+    satInstance.nbVariables = nbVariables;
+}
+
+std::vector<Variable> SymmetryBreaking::restoreModel(const std::vector<Variable> &model) const
+{
+    if (model.size() != static_cast<size_t>(nbVariables + nbAuxiliaryVariables) + 1) {
+        return model; // UNSAT or UNKNOWN without model
+    }
+    return vector<Variable>(model.begin(), model.begin() + nbVariables + 1);
+}
+
+std::size_t SymmetryBreaking::getNbGenerators() const
+{
+    return nbGenerators;
+}
+
+std::size_t SymmetryBreaking::getNbClauses() const
+{
+    return clauses.size();
+}
+
+double SymmetryBreaking::getDetectionTime() const
+{
+    return detectionTime;
+}
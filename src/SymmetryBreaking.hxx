@@ -0,0 +1,71 @@
+#ifndef FREAKSATSOLVER_SYMMETRYBREAKING_HXX
+#define FREAKSATSOLVER_SYMMETRYBREAKING_HXX
+
+#include <cstddef>
+#include <vector>
+#include "Solver.hxx"
+
+/**
+ * Symmetry-breaking preprocessing. Formula is turned into colored graph (node per literal of used variable, node per
+ * clause, edges between complementary literals and between clause and its literals), generators of its automorphism
+ * group are found by @c AutomorphismSearch and each of them is mapped to permutation of literals which maps formula
+ * onto itself. Lex-leader constraint x <= g(x) over moved variables in increasing order is added for each generator,
+ * encoded by clauses over auxiliary variables, until clause budget runs out. Lexicographically least model of every
+ * orbit satisfies all constraints (and their prefixes), so satisfiability is preserved.
+ */
+class SymmetryBreaking
+{
+    typedef Solver::Literal Literal;
+    typedef Solver::Clause Clause;
+
+    static constexpr unsigned long long searchWork = 100000000; // edges scanned by automorphism search
+
+    Literal nbVariables;              // of formula without breaking clauses
+    unsigned nbClauses;
+    Literal nbAuxiliaryVariables = 0;
+    std::vector<Clause> clauses;
+    std::size_t nbGenerators = 0;
+    double detectionTime = 0;
+
+public:
+    /**
+     * Detects symmetries of clauses of @c satInstance and encodes up to @c maxClauses breaking clauses
+     */
+    SymmetryBreaking(const Solver &satInstance, std::size_t maxClauses);
+
+    /**
+     * Appends breaking clauses and their auxiliary variables to formula
+     */
+    void apply(Solver &satInstance) const;
+
+    /**
+     * Removes breaking clauses and auxiliary variables
+     */
+    void restore(Solver &satInstance) const;
+
+    /**
+     * Model with auxiliary variables -> model over variables of formula
+     */
+    std::vector<Variable> restoreModel(const std::vector<Variable> &model) const;
+
+    /**
+     * Generators which move at least one variable
+     */
+    std::size_t getNbGenerators() const;
+
+    std::size_t getNbClauses() const;
+
+    /**
+     * Seconds spent by graph construction and automorphism search
+     */
+    double getDetectionTime() const;
+
+private:
+    /**
+     * Encodes x <= @c image(x) lexicographically over @c moved variables, returns false once budget ran out
+     */
+    bool addLexLeader(const std::vector<Literal> &moved, const std::vector<Literal> &image, std::size_t maxClauses);
+};
+
+
+#endif //FREAKSATSOLVER_SYMMETRYBREAKING_HXX
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+#include "VariableRenumbering.hxx"
+
+using namespace std;
+
+VariableRenumbering::VariableRenumbering(const Solver &satInstance) : original(1, 0),
+                                                                      renumbered(satInstance.nbVariables + 1)
+{
+    auto nbVariables = satInstance.nbVariables;
+    // constraints interact with their variables just like clauses
+    vector<const vector<Literal> *> edges;
+    for (unsigned i = 0; i < satInstance.nbClauses; ++i) {
+        edges.push_back(&satInstance.formula[i]);
+    }
+    for (auto &constraint : satInstance.cardinalityConstraints) {
+        edges.push_back(&constraint.literals);
+    }
+    for (auto &constraint : satInstance.xorConstraints) {
+        edges.push_back(&constraint.variables);
+    }
+
+    // occurrences of variable v are occurrences[start[v]] .. occurrences[start[v + 1] - 1]
+    vector<size_t> start(nbVariables + 2);
+    for (auto edge : edges) {
+        for (auto l : *edge) {
+            ++start[abs(l) + 1];
+        }
+    }
+    for (Literal v = 1; v <= nbVariables + 1; ++v) {
+        start[v] += start[v - 1];
+    }
+    vector<unsigned> occurrences(start.back());
+    vector<size_t> next(start.begin(), start.end() - 1);
+    for (unsigned i = 0; i < edges.size(); ++i) {
+        for (auto l : *edges[i]) {
+            occurrences[next[abs(l)]++] = i;
+        }
+    }
+    auto degree = [&start](Literal v) { return start[v + 1] - start[v]; };
+    auto lessOccurring = [&degree](Literal a, Literal b) { return degree(a) < degree(b); };
+
+    vector<Literal> byDegree(nbVariables);
+    for (Literal v = 1; v <= nbVariables; ++v) {
+        byDegree[v - 1] = v;
+    }
+    stable_sort(byDegree.begin(), byDegree.end(), lessOccurring);
+    vector<bool> visited(nbVariables + 1);
+    vector<bool> expanded(edges.size());
+    original.reserve(nbVariables + 1);
+    for (auto root : byDegree) {
+        if (visited[root] || degree(root) == 0) {
+            continue;
+        }
+        visited[root] = true;
+        original.push_back(root);
+        for (size_t head = original.size() - 1; head < original.size(); ++head) {
+            auto v = original[head];
+            auto discovered = original.size();
+            // each edge is scanned once, search is linear in formula size
+            for (auto i = start[v]; i < start[v + 1]; ++i) {
+                auto edge = occurrences[i];
+                if (expanded[edge]) {
+                    continue;
+                }
+                expanded[edge] = true;
+                for (auto l : *edges[edge]) {
+                    if (!visited[abs(l)]) {
+                        visited[abs(l)] = true;
+                        original.push_back(abs(l));
+                    }
+                }
+            }
+            stable_sort(original.begin() + discovered, original.end(), lessOccurring);
+        }
+    }
+    reverse(original.begin() + 1, original.end());
+    for (auto v : byDegree) {
+        if (!visited[v]) {
+            original.push_back(v);
+        }
+    }
+    for (Literal v = 1; v <= nbVariables; ++v) {
+        renumbered[original[v]] = v;
+    }
+}
+
+void VariableRenumbering::apply(Solver &satInstance) const
+{
+    rename(satInstance, renumbered);
+    vector<pair<Literal, unsigned>> keys(satInstance.nbClauses);
+    for (unsigned i = 0; i < satInstance.nbClauses; ++i) {
+        auto &clause = satInstance.formula[i];
+        keys[i].first = clause.empty() ? 0 : abs(*min_element(clause.begin(), clause.end(), [](Literal a, Literal b) {
+            return abs(a) < abs(b);
+        }));
+        keys[i].second = i;
+    }
+    sort(keys.begin(), keys.end());
+    Solver::Formula sorted(satInstance.formula.size());
+    for (unsigned i = 0; i < satInstance.nbClauses; ++i) {
+        sorted[i] = move(satInstance.formula[keys[i].second]);
+    }
+    satInstance.formula = move(sorted);
+}
+
+void VariableRenumbering::restore(Solver &satInstance) const
+{
+    rename(satInstance, original);
+}
+
+std::vector<Variable> VariableRenumbering::restoreModel(const std::vector<Variable> &model) const
+{
+    if (model.size() != original.size()) {
+        return model; // UNSAT or UNKNOWN without model
+    }
+    vector<Variable> restored(model.size());
+    restored[0] = model[0];
+    for (size_t v = 1; v < model.size(); ++v) {
+        restored[original[v]] = model[v];
+    }
+    return restored;
+}
+
+void VariableRenumbering::rename(Solver &satInstance, const std::vector<Literal> &mapping)
+{
+    auto renameLiteral = [&mapping](Literal l) { return l > 0 ? mapping[l] : -mapping[-l]; };
+    for (auto &clause : satInstance.formula) {
+        transform(clause.begin(), clause.end(), clause.begin(), renameLiteral);
+    }
+    // parser keeps constraint literals sorted
+    for (auto &constraint : satInstance.cardinalityConstraints) {
+        transform(constraint.literals.begin(), constraint.literals.end(), constraint.literals.begin(), renameLiteral);
+        sort(constraint.literals.begin(), constraint.literals.end());
+    }
+    for (auto &constraint : satInstance.xorConstraints) {
+        transform(constraint.variables.begin(), constraint.variables.end(), constraint.variables.begin(),
+                  renameLiteral);
+        sort(constraint.variables.begin(), constraint.variables.end());
+    }
+}
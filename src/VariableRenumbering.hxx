@@ -0,0 +1,46 @@
+#ifndef FREAKSATSOLVER_VARIABLERENUMBERING_HXX
+#define FREAKSATSOLVER_VARIABLERENUMBERING_HXX
+
+#include <vector>
+#include "Solver.hxx"
+
+/**
+ * Numbering of variables which places variables sharing clause close to each other (reverse Cuthill-McKee over
+ * clause-variable incidence). Breadth-first search starts in the least occurring unvisited variable of each
+ * component and visits neighbours from the least occurring one, so that per-variable arrays and watch lists of
+ * variables propagated together share cache lines and pages. Variables occurring in no clause get the last numbers.
+ */
+class VariableRenumbering
+{
+    typedef Solver::Literal Literal;
+
+    std::vector<Literal> original;   // new variable -> original variable
+    std::vector<Literal> renumbered; // original variable -> new variable
+
+public:
+    explicit VariableRenumbering(const Solver &satInstance);
+
+    /**
+     * Rewrites clauses and extended constraints to new numbering and sorts clauses by their lowest variable
+     */
+    void apply(Solver &satInstance) const;
+
+    /**
+     * Rewrites clauses and extended constraints back to original numbering, order of clauses is kept
+     */
+    void restore(Solver &satInstance) const;
+
+    /**
+     * Model over new variables -> model over original variables
+     */
+    std::vector<Variable> restoreModel(const std::vector<Variable> &model) const;
+
+private:
+    /**
+     * Rewrites all literals of @c satInstance through @c mapping
+     */
+    static void rename(Solver &satInstance, const std::vector<Literal> &mapping);
+};
+
+
+#endif //FREAKSATSOLVER_VARIABLERENUMBERING_HXX
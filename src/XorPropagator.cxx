@@ -0,0 +1,256 @@
+#include <cassert>
+#include <algorithm>
+#include "XorPropagator.hxx"
+
+using namespace std;
+
+constexpr unsigned XorPropagator::noColumn;
+constexpr unsigned XorPropagator::wordBits;
+constexpr unsigned XorPropagator::noConflict;
+
+XorPropagator::XorPropagator(const std::vector<XorConstraint> &constraints, int nbVariables, const Variable *value,
+                             const std::vector<int> &level) : variableColumn(nbVariables + 1, noColumn),
+                                                              value(value),
+                                                              level(level)
+{
+    for (auto &constraint : constraints) {
+        for (auto v : constraint.variables) {
+            if (variableColumn[v] == noColumn) {
+                variableColumn[v] = columnVariable.size();
+                columnVariable.push_back(v);
+            }
+        }
+    }
+    rowWords = (columnVariable.size() + wordBits - 1) / wordBits;
+    matrix.resize(constraints.size() * rowWords);
+    for (unsigned rowIdx = 0; rowIdx < constraints.size(); ++rowIdx) {
+        for (auto v : constraints[rowIdx].variables) {
+            auto column = variableColumn[v];
+            row(rowIdx)[column / wordBits] ^= Word(1) << column % wordBits;
+        }
+        parity.push_back(constraints[rowIdx].parity);
+    }
+
+    // Gauss-Jordan elimination to reduced row echelon form
+    unsigned rank = 0;
+    for (unsigned column = 0; column < columnVariable.size() && rank < parity.size(); ++column) {
+        unsigned pivotRow = rank;
+        while (pivotRow < parity.size() && !contains(pivotRow, column)) {
+            ++pivotRow;
+        }
+        if (pivotRow == parity.size()) {
+            continue;
+        }
+        swap_ranges(row(pivotRow), row(pivotRow) + rowWords, row(rank));
+        swap(parity[pivotRow], parity[rank]);
+        for (unsigned rowIdx = 0; rowIdx < parity.size(); ++rowIdx) {
+            if (rowIdx != rank && contains(rowIdx, column)) {
+                for (unsigned w = 0; w < rowWords; ++w) {
+                    row(rowIdx)[w] ^= row(rank)[w];
+                }
+                parity[rowIdx] ^= parity[rank];
+            }
+        }
+        basic.push_back(column);
+        ++rank;
+    }
+    // remaining rows are empty, 0 = 1 means constraints contradict each other
+    for (unsigned rowIdx = rank; rowIdx < parity.size(); ++rowIdx) {
+        inconsistent = inconsistent || parity[rowIdx];
+    }
+    matrix.resize(rank * rowWords);
+    parity.resize(rank);
+
+    watched.resize(rank, noColumn);
+    watches.resize(columnVariable.size());
+    isDirty.resize(rank);
+    rowVisit.resize(rank);
+    for (unsigned rowIdx = 0; rowIdx < rank; ++rowIdx) {
+        watches[basic[rowIdx]].push_back(rowIdx);
+        watch(rowIdx, findUnassigned(rowIdx, basic[rowIdx]));
+        if (watched[rowIdx] == noColumn) {
+            unitRows.push_back(rowIdx);
+        }
+    }
+}
+
+unsigned XorPropagator::propagate(int v, std::vector<ConstraintImplication> &implied)
+{
+    auto column = variableColumn[v];
+    if (column == noColumn) {
+        return noConflict;
+    }
+    unsigned conflict = noConflict;
+    auto &list = watches[column];
+    ++visit;
+    size_t j = 0;
+    // update may append to list, such entries are visited too
+    for (size_t i = 0; i < list.size(); ++i) {
+        auto rowIdx = list[i];
+        if ((basic[rowIdx] != column && watched[rowIdx] != column) || rowVisit[rowIdx] == visit) {
+            continue; // stale or duplicate entry
+        }
+        rowVisit[rowIdx] = visit;
+        auto rowConflict = update(rowIdx, implied);
+        if (conflict == noConflict) {
+            conflict = rowConflict;
+        }
+        if (basic[rowIdx] == column || watched[rowIdx] == column) {
+            list[j++] = rowIdx;
+        }
+    }
+    list.resize(j);
+    // rows changed by elimination, updated even after conflict so that their watches stay valid
+    while (!dirtyRows.empty()) {
+        auto rowIdx = dirtyRows.back();
+        dirtyRows.pop_back();
+        isDirty[rowIdx] = false;
+        auto rowConflict = update(rowIdx, implied);
+        if (conflict == noConflict) {
+            conflict = rowConflict;
+        }
+    }
+    return conflict;
+}
+
+unsigned XorPropagator::propagateUnits(std::vector<ConstraintImplication> &implied)
+{
+    for (auto rowIdx : unitRows) {
+        auto v = columnVariable[basic[rowIdx]];
+        if (value[v] == Variable::UNKNOWN) {
+            implied.push_back({parity[rowIdx] ? v : -v, snapshot(rowIdx), true});
+        } else if ((value[v] == Variable::POSITIVE) != static_cast<bool>(parity[rowIdx])) {
+            return snapshot(rowIdx);
+        }
+    }
+    return noConflict;
+}
+
+void XorPropagator::reasonVariables(unsigned reason, int skip, std::vector<int> &variables) const
+{
+    for (unsigned w = 0; w < rowWords; ++w) {
+        for (auto bits = reasons[reason + w]; bits != 0; bits &= bits - 1) {
+            auto v = columnVariable[w * wordBits + __builtin_ctzll(bits)];
+            if (v != skip) {
+                variables.push_back(v);
+            }
+        }
+    }
+}
+
+bool XorPropagator::isSatisfied() const
+{
+    for (unsigned rowIdx = 0; rowIdx < parity.size(); ++rowIdx) {
+        if (findUnassigned(rowIdx, noColumn) != noColumn || assignedParity(rowIdx) != parity[rowIdx]) {
+            return false;
+        }
+    }
+    return !inconsistent;
+}
+
+unsigned XorPropagator::findUnassigned(unsigned rowIdx, unsigned skip) const
+{
+    auto words = row(rowIdx);
+    for (unsigned w = 0; w < rowWords; ++w) {
+        for (auto bits = words[w]; bits != 0; bits &= bits - 1) {
+            unsigned column = w * wordBits + __builtin_ctzll(bits);
+            if (column != skip && !isAssigned(column)) {
+                return column;
+            }
+        }
+    }
+    return noColumn;
+}
+
+unsigned XorPropagator::latestNonBasic(unsigned rowIdx) const
+{
+    auto words = row(rowIdx);
+    unsigned latest = noColumn;
+    for (unsigned w = 0; w < rowWords; ++w) {
+        for (auto bits = words[w]; bits != 0; bits &= bits - 1) {
+            unsigned column = w * wordBits + __builtin_ctzll(bits);
+            if (column != basic[rowIdx] &&
+                (latest == noColumn || level[columnVariable[column]] > level[columnVariable[latest]])) {
+                latest = column;
+            }
+        }
+    }
+    return latest;
+}
+
+bool XorPropagator::assignedParity(unsigned rowIdx) const
+{
+    auto words = row(rowIdx);
+    bool result = false;
+    for (unsigned w = 0; w < rowWords; ++w) {
+        for (auto bits = words[w]; bits != 0; bits &= bits - 1) {
+            result ^= value[columnVariable[w * wordBits + __builtin_ctzll(bits)]] == Variable::POSITIVE;
+        }
+    }
+    return result;
+}
+
+unsigned XorPropagator::update(unsigned rowIdx, std::vector<ConstraintImplication> &implied)
+{
+    if (isAssigned(basic[rowIdx])) {
+        auto column = findUnassigned(rowIdx, basic[rowIdx]);
+        if (column != noColumn) {
+            pivot(rowIdx, column);
+        }
+    }
+    auto basicColumn = basic[rowIdx];
+    if (isAssigned(basicColumn)) {
+        // whole row assigned
+        watch(rowIdx, latestNonBasic(rowIdx));
+        return assignedParity(rowIdx) == parity[rowIdx] ? noConflict : snapshot(rowIdx);
+    }
+    auto column = watched[rowIdx];
+    if (column == noColumn || column == basicColumn || !contains(rowIdx, column) || isAssigned(column)) {
+        column = findUnassigned(rowIdx, basicColumn);
+    }
+    if (column != noColumn) {
+        watch(rowIdx, column);
+        return noConflict;
+    }
+    // basic variable is the only unassigned one, watch stays on column unassigned first by backtracking
+    watch(rowIdx, latestNonBasic(rowIdx));
+    auto v = columnVariable[basicColumn];
+    bool positive = parity[rowIdx] != assignedParity(rowIdx);
+    implied.push_back({positive ? v : -v, snapshot(rowIdx), watched[rowIdx] == noColumn});
+    return noConflict;
+}
+
+void XorPropagator::pivot(unsigned rowIdx, unsigned column)
+{
+    for (unsigned other = 0; other < parity.size(); ++other) {
+        if (other != rowIdx && contains(other, column)) {
+            for (unsigned w = 0; w < rowWords; ++w) {
+                row(other)[w] ^= row(rowIdx)[w];
+            }
+            parity[other] ^= parity[rowIdx];
+            if (!isDirty[other]) {
+                isDirty[other] = true;
+                dirtyRows.push_back(other);
+            }
+        }
+    }
+    basic[rowIdx] = column;
+    watches[column].push_back(rowIdx);
+}
+
+void XorPropagator::watch(unsigned rowIdx, unsigned column)
+{
+    if (watched[rowIdx] != column) {
+        watched[rowIdx] = column;
+        if (column != noColumn) {
+            watches[column].push_back(rowIdx);
+        }
+    }
+}
+
+unsigned XorPropagator::snapshot(unsigned rowIdx)
+{
+    unsigned reason = reasons.size();
+    reasons.insert(reasons.end(), row(rowIdx), row(rowIdx) + rowWords);
+    return reason;
+}
@@ -0,0 +1,153 @@
+#ifndef FREAKSATSOLVER_XORPROPAGATOR_HXX
+#define FREAKSATSOLVER_XORPROPAGATOR_HXX
+
+#include <cstdint>
+#include <vector>
+#include "Variable.hxx"
+#include "ExtendedConstraints.hxx"
+
+/**
+ * Propagation of XOR constraints by incremental Gauss-Jordan elimination. Constraints form matrix over GF(2) which is
+ * kept in reduced row echelon form, every row has basic column which no other row contains. Each row watches its basic
+ * column and one non-basic column. When basic variable gets assigned, row pivots to unassigned non-basic column and
+ * eliminates it from other rows, so row becomes unit exactly when its basic variable is the only unassigned one.
+ * Elimination is never undone by backtracking, rows stay linear combinations of original constraints.
+ *
+ * Rows change by elimination, so reason of implication is snapshot of row taken when literal was implied. Reason
+ * clause is generated from snapshot only when conflict analysis needs it.
+ */
+class XorPropagator
+{
+    typedef std::uint64_t Word;
+
+    static constexpr unsigned noColumn = ~0u;
+    static constexpr unsigned wordBits = 64;
+
+    std::vector<int> columnVariable;           // column -> variable
+    std::vector<unsigned> variableColumn;      // variable -> column or noColumn
+    unsigned rowWords;                         // words of single row
+    std::vector<Word> matrix;                  // rows one after another
+    std::vector<char> parity;                  // row -> right hand side
+    std::vector<unsigned> basic;               // row -> basic column
+    std::vector<unsigned> watched;             // row -> watched non-basic column or noColumn
+    std::vector<std::vector<unsigned>> watches; // column -> rows whose basic or watched column it is, may be stale
+    std::vector<unsigned> unitRows;            // rows without non-basic columns
+    std::vector<unsigned> dirtyRows;           // rows changed by elimination waiting for watch update
+    std::vector<char> isDirty;
+    std::vector<unsigned> rowVisit;            // row -> last watch list visit, drops duplicate watch entries
+    unsigned visit = 0;
+    std::vector<Word> reasons;                 // snapshots of rows, reason of implication is offset of snapshot
+    bool inconsistent = false;
+    const Variable *value;                     // engine values, value[v] is value of variable v
+    const std::vector<int> &level;             // variable -> decision level of assignment
+
+public:
+    static constexpr unsigned noConflict = ~0u;
+
+    XorPropagator(const std::vector<XorConstraint> &constraints, int nbVariables, const Variable *value,
+                  const std::vector<int> &level);
+
+    XorPropagator(const XorPropagator &) = delete;
+
+    XorPropagator &operator=(const XorPropagator &) = delete;
+
+    bool empty() const
+    {
+        return parity.empty();
+    }
+
+    /**
+     * Constraints contradict each other, found by initial elimination
+     */
+    bool isInconsistent() const
+    {
+        return inconsistent;
+    }
+
+    /**
+     * Variable @c v has been assigned. Appends implied literals to @c implied, returns reason of conflict (snapshot
+     * of violated row) or noConflict. Implied literals are not assigned yet, so they may contradict each other.
+     */
+    unsigned propagate(int v, std::vector<ConstraintImplication> &implied);
+
+    /**
+     * Implies variables of rows containing single variable, they are never triggered by assignment
+     */
+    unsigned propagateUnits(std::vector<ConstraintImplication> &implied);
+
+    /**
+     * Appends variables of snapshot @c reason except @c skip (0 keeps all)
+     */
+    void reasonVariables(unsigned reason, int skip, std::vector<int> &variables) const;
+
+    /**
+     * Reasons created since @c reasonCount() returned @c count are no longer referenced
+     */
+    void releaseReasons(unsigned count)
+    {
+        reasons.resize(count);
+    }
+
+    unsigned reasonCount() const
+    {
+        return reasons.size();
+    }
+
+    /**
+     * Checks all rows under current assignment
+     */
+    bool isSatisfied() const;
+
+private:
+    Word *row(unsigned rowIdx)
+    {
+        return matrix.data() + rowIdx * rowWords;
+    }
+
+    const Word *row(unsigned rowIdx) const
+    {
+        return matrix.data() + rowIdx * rowWords;
+    }
+
+    bool contains(unsigned rowIdx, unsigned column) const
+    {
+        return (row(rowIdx)[column / wordBits] >> column % wordBits) & 1;
+    }
+
+    bool isAssigned(unsigned column) const
+    {
+        return value[columnVariable[column]] != Variable::UNKNOWN;
+    }
+
+    /**
+     * Unassigned column of row other than @c skip or noColumn
+     */
+    unsigned findUnassigned(unsigned rowIdx, unsigned skip) const;
+
+    /**
+     * Non-basic column of row assigned at highest level or noColumn if row has no non-basic column
+     */
+    unsigned latestNonBasic(unsigned rowIdx) const;
+
+    /**
+     * Parity of assigned columns of row
+     */
+    bool assignedParity(unsigned rowIdx) const;
+
+    /**
+     * Restores watches of row whose watched variable got assigned or which changed by elimination. Appends
+     * implication if row is unit, returns snapshot if row is violated.
+     */
+    unsigned update(unsigned rowIdx, std::vector<ConstraintImplication> &implied);
+
+    /**
+     * Makes @c column basic column of row and eliminates it from other rows
+     */
+    void pivot(unsigned rowIdx, unsigned column);
+
+    void watch(unsigned rowIdx, unsigned column);
+
+    unsigned snapshot(unsigned rowIdx);
+};
+
+#endif //FREAKSATSOLVER_XORPROPAGATOR_HXX